@@ -5,7 +5,6 @@
  *
  * Tests to add:
  * - string/bytes
- * - unknown field handler called appropriately
  * - unknown fields can be inserted in random places
  * - fuzzing of valid input
  * - resource limits (max stack depth, max string len)
@@ -32,7 +31,14 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <deque>
 #include <sstream>
+#include <vector>
+
+#ifndef UPB_THREAD_UNSAFE
+#include <pthread.h>
+#endif
 
 #include "tests/test_util.h"
 #include "tests/upb_test.h"
@@ -270,6 +276,26 @@ bool value_bool(int* depth, const uint32_t* num, bool val) {
   return true;
 }
 
+// Array handlers print exactly what the value handlers would, so packed fields
+// produce the same output whichever path the decoder takes.
+#define NUMERIC_ARRAY_HANDLER(member, ctype)                      \
+  bool array_##member(int* depth, const uint32_t* num,            \
+                      const ctype* vals, size_t n) {              \
+    ASSERT(n > 0);                                                \
+    for (size_t i = 0; i < n; i++) {                              \
+      value_##member(depth, num, vals[i]);                        \
+    }                                                             \
+    return true;                                                  \
+  }
+
+NUMERIC_ARRAY_HANDLER(uint32, uint32_t)
+NUMERIC_ARRAY_HANDLER(uint64, uint64_t)
+NUMERIC_ARRAY_HANDLER(int32,  int32_t)
+NUMERIC_ARRAY_HANDLER(int64,  int64_t)
+NUMERIC_ARRAY_HANDLER(float,  float)
+NUMERIC_ARRAY_HANDLER(double, double)
+NUMERIC_ARRAY_HANDLER(bool,   bool)
+
 int* startstr(int* depth, const uint32_t* num, size_t size_hint) {
   check_stack_alignment();
   indentbuf(&output, *depth);
@@ -498,7 +524,17 @@ upb::reffed_ptr<const upb::MessageDef> NewMessageDef() {
   return md;
 }
 
-upb::reffed_ptr<const upb::Handlers> NewHandlers(TestMode mode) {
+#define REG_ARRAY(h, type, utype, member)                                \
+  do {                                                                   \
+    uint32_t num = rep_fn(type);                                         \
+    const upb::FieldDef* f = (h)->message_def()->FindFieldByNumber(num); \
+    ASSERT(f);                                                           \
+    ASSERT((h)->Set##utype##ArrayHandler(                                \
+        f, UpbBind(array_##member, new uint32_t(num))));                 \
+  } while (0)
+
+upb::reffed_ptr<const upb::Handlers> NewHandlers(TestMode mode,
+                                                 bool arrays = false) {
   upb::reffed_ptr<upb::Handlers> h(upb::Handlers::New(NewMessageDef().get()));
 
   if (mode == ALL_HANDLERS) {
@@ -521,6 +557,23 @@ upb::reffed_ptr<const upb::Handlers> NewHandlers(TestMode mode) {
     reg<int32_t,  value_int32> (h.get(), UPB_DESCRIPTOR_TYPE_SINT32);
     reg<int64_t,  value_int64> (h.get(), UPB_DESCRIPTOR_TYPE_SINT64);
 
+    if (arrays) {
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_DOUBLE, Double, double);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_FLOAT, Float, float);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_INT64, Int64, int64);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_UINT64, UInt64, uint64);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_INT32, Int32, int32);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_FIXED64, UInt64, uint64);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_FIXED32, UInt32, uint32);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_BOOL, Bool, bool);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_UINT32, UInt32, uint32);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_ENUM, Int32, int32);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_SFIXED32, Int32, int32);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_SFIXED64, Int64, int64);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_SINT32, Int32, int32);
+      REG_ARRAY(h, UPB_DESCRIPTOR_TYPE_SINT64, Int64, int64);
+    }
+
     reg_str(h.get(), UPB_DESCRIPTOR_TYPE_STRING);
     reg_str(h.get(), UPB_DESCRIPTOR_TYPE_BYTES);
     reg_str(h.get(), rep_fn(UPB_DESCRIPTOR_TYPE_STRING));
@@ -651,10 +704,12 @@ void do_run_decoder(VerboseParserEnvironment* env, upb::pb::Decoder* decoder,
   (*count)++;
 }
 
-void run_decoder(const string& proto, const string* expected_output) {
+void run_decoder(const string& proto, const string* expected_output,
+                 bool delimited = false) {
   VerboseParserEnvironment env(filter_hash != 0);
   upb::Sink sink(global_handlers, &closures[0]);
   upb::pb::Decoder *decoder = CreateDecoder(env.env(), global_method, &sink);
+  ASSERT(decoder->set_delimited(delimited));
   env.ResetBytesSink(decoder->input());
   for (size_t i = 0; i < proto.size(); i++) {
     for (size_t j = i; j < UPB_MIN(proto.size(), i + 5); j++) {
@@ -947,6 +1002,23 @@ void test_invalid() {
                          cat( tag(12345, UPB_WIRE_TYPE_64BIT), uint64(0))),
            submsg(UPB_DESCRIPTOR_TYPE_MESSAGE, string("     "))));
 
+  // Mismatched END_GROUP inside nested unknown groups.
+  assert_does_not_parse(
+      cat( tag(12345, UPB_WIRE_TYPE_START_GROUP),
+           tag(12346, UPB_WIRE_TYPE_START_GROUP),
+           tag(12345, UPB_WIRE_TYPE_END_GROUP),
+           tag(12346, UPB_WIRE_TYPE_END_GROUP) ));
+
+  // Unknown groups count against the stack depth like any others.
+  {
+    string buf;
+    for (int i = 0; i <= MAX_NESTING; i++) {
+      buf = cat( tag(12345, UPB_WIRE_TYPE_START_GROUP), buf,
+                 tag(12345, UPB_WIRE_TYPE_END_GROUP) );
+    }
+    assert_does_not_parse(buf);
+  }
+
   // Test exceeding the resource limit of stack depth.
   if (test_mode != NO_HANDLERS) {
     string buf;
@@ -1195,6 +1267,33 @@ void test_valid() {
       LINE(">")
   );
 
+  // A long run of unknown fields, and unknown groups nested both less and
+  // more deeply than the decoder skips without pushing frames.
+  string unknown_run;
+  for (int i = 0; i < 50; i++) {
+    unknown_run += cat( tag(12345 + i, UPB_WIRE_TYPE_VARINT),
+                        varint(UINT64_MAX >> i),
+                        tag(123, UPB_WIRE_TYPE_DELIMITED), delim(string(i, 'x')),
+                        tag(123477, UPB_WIRE_TYPE_64BIT), uint64(i) );
+  }
+  for (int depth = 20; depth <= 40; depth += 20) {
+    string nested = unknown_group_with_data;
+    for (int i = 0; i < depth; i++) {
+      nested = cat( tag(unknown_group_fn + i, UPB_WIRE_TYPE_START_GROUP),
+                    tag(123477, UPB_WIRE_TYPE_64BIT), uint64(i), nested,
+                    tag(unknown_group_fn + i, UPB_WIRE_TYPE_END_GROUP) );
+    }
+    assert_successful_parse(
+        cat( unknown_run, nested,
+             tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT), varint(1),
+             unknown_run ),
+        LINE("<")
+        LINE("%u:1")
+        LINE(">"),
+        UPB_DESCRIPTOR_TYPE_INT32
+    );
+  }
+
   // Staying within the stack limit should work properly.
   string buf;
   string textbuf;
@@ -1222,10 +1321,12 @@ void test_valid() {
 }
 
 upb::reffed_ptr<const upb::pb::DecoderMethod> NewMethod(
-    const upb::Handlers* dest_handlers, bool allow_jit) {
+    const upb::Handlers* dest_handlers, bool allow_jit, bool lazy = false) {
   upb::pb::CodeCache cache;
   cache.set_allow_jit(allow_jit);
-  return cache.GetDecoderMethod(upb::pb::DecoderMethodOptions(dest_handlers));
+  upb::pb::DecoderMethodOptions opts(dest_handlers);
+  opts.set_lazy(lazy);
+  return cache.GetDecoderMethod(opts);
 }
 
 void test_emptyhandlers(bool allowjit) {
@@ -1271,6 +1372,1089 @@ upb::reffed_ptr<const upb::pb::DecoderMethod> method =
   }
 }
 
+// A message with many sparse field numbers, so that dispatch has to hash most
+// of them.  Fields are sent in the opposite order from the bytecode, so every
+// one goes through dispatch.
+void test_sparse_fieldnums(bool allowjit) {
+  const int kFields = 300;
+  upb::reffed_ptr<upb::MessageDef> md = upb::MessageDef::New();
+  ASSERT(md->set_full_name("SparseTest", NULL));
+  std::vector<uint32_t> nums;
+  for (int i = 0; i < kFields; i++) {
+    uint32_t fn = (i * 7919 + 3) % (UPB_MAX_FIELDNUMBER - 1) + 1;
+    nums.push_back(fn);
+    AddField(UPB_DESCRIPTOR_TYPE_INT32, "f" + num2string(i), fn, false,
+             md.get());
+  }
+  ASSERT(md->Freeze(NULL));
+
+  upb::reffed_ptr<upb::Handlers> h(upb::Handlers::New(md.get()));
+  h->SetStartMessageHandler(UpbMakeHandler(startmsg));
+  h->SetEndMessageHandler(UpbMakeHandler(endmsg));
+  for (int i = 0; i < kFields; i++) {
+    doreg<int32_t, value_int32>(h.get(), nums[i]);
+  }
+  ASSERT(h->Freeze(NULL));
+
+  upb::reffed_ptr<const upb::pb::DecoderMethod> method =
+      NewMethod(h.get(), allowjit);
+  string proto;
+  string expected = LINE("<");
+  for (int i = kFields - 1; i >= 0; i--) {
+    proto += cat(tag(nums[i], UPB_WIRE_TYPE_VARINT), varint(i));
+    expected += num2string(nums[i]) + ":" + num2string(i) + "\n";
+  }
+  // Unknown fields must still be skipped.
+  proto += cat(tag(UNKNOWN_FIELD, UPB_WIRE_TYPE_VARINT), varint(1));
+  expected += LINE(">");
+
+  VerboseParserEnvironment env(filter_hash != 0);
+  upb::Sink sink(h.get(), &closures[0]);
+  upb::pb::Decoder* decoder = CreateDecoder(env.env(), method.get(), &sink);
+  env.ResetBytesSink(decoder->input());
+  env.Reset(proto.data(), proto.size(), true, false);
+  output.clear();
+  ASSERT(env.Start());
+  ASSERT(env.ParseBuffer(-1));
+  ASSERT(env.End());
+  ASSERT(env.CheckConsistency());
+  if (test_mode == ALL_HANDLERS) {
+    ASSERT(output == expected);
+  }
+}
+
+// Packed fields with array handlers are delivered in batches; the output has
+// to be the same as value-at-a-time decoding, however the input is split.
+void test_packed_arrays(bool allowjit) {
+  upb::reffed_ptr<const upb::Handlers> handlers =
+      NewHandlers(test_mode, true);
+  upb::reffed_ptr<const upb::pb::DecoderMethod> method =
+      NewMethod(handlers.get(), allowjit);
+  const upb::Handlers* old_handlers = global_handlers;
+  const upb::pb::DecoderMethod* old_method = global_method;
+  global_handlers = handlers.get();
+  global_method = method.get();
+
+  test_valid_data_for_signed_type(UPB_DESCRIPTOR_TYPE_DOUBLE,
+                                  dbl(33),
+                                  dbl(-66));
+  test_valid_data_for_signed_type(UPB_DESCRIPTOR_TYPE_FLOAT, flt(33), flt(-66));
+  test_valid_data_for_signed_type(UPB_DESCRIPTOR_TYPE_INT64,
+                                  varint(33),
+                                  varint(-66));
+  test_valid_data_for_signed_type(UPB_DESCRIPTOR_TYPE_INT32,
+                                  varint(33),
+                                  varint(-66));
+  test_valid_data_for_signed_type(UPB_DESCRIPTOR_TYPE_ENUM,
+                                  varint(33),
+                                  varint(-66));
+  test_valid_data_for_signed_type(UPB_DESCRIPTOR_TYPE_SINT32,
+                                  zz32(33),
+                                  zz32(-66));
+  test_valid_data_for_signed_type(UPB_DESCRIPTOR_TYPE_SINT64,
+                                  zz64(33),
+                                  zz64(-66));
+  test_valid_data_for_type(UPB_DESCRIPTOR_TYPE_UINT64, varint(33), varint(66));
+  test_valid_data_for_signed_type(UPB_DESCRIPTOR_TYPE_SFIXED32,
+                                  uint32(33),
+                                  uint32(-66));
+  test_valid_data_for_signed_type(UPB_DESCRIPTOR_TYPE_SFIXED64,
+                                  uint64(33),
+                                  uint64(-66));
+  test_valid_data_for_type(UPB_DESCRIPTOR_TYPE_UINT32, varint(33), varint(66));
+  test_valid_data_for_type(UPB_DESCRIPTOR_TYPE_FIXED64, uint64(33), uint64(66));
+  test_valid_data_for_type(UPB_DESCRIPTOR_TYPE_FIXED32, uint32(33), uint32(66));
+
+  // More values than fit in one batch, mixing one-byte and long varints.
+  uint32_t fn = rep_fn(UPB_DESCRIPTOR_TYPE_UINT64);
+  string packed;
+  string expected = LINE("<") + num2string(fn) + LINE(":[");
+  for (uint64_t i = 0; i < 150; i++) {
+    uint64_t val = (i % 17 == 0) ? (UINT64_MAX >> (i % 64)) : i;
+    packed += varint(val);
+    appendf(&expected, "  %" PRIu32 ":%" PRIu64 "\n", fn, val);
+  }
+  expected += LINE("]") LINE(">");
+  run_decoder(cat( tag(fn, UPB_WIRE_TYPE_DELIMITED), delim(packed) ),
+              &expected);
+
+  // A fixed-width run long enough to be split across several calls.
+  uint32_t dbl_fn = rep_fn(UPB_DESCRIPTOR_TYPE_DOUBLE);
+  packed.clear();
+  expected = LINE("<") + num2string(dbl_fn) + LINE(":[");
+  for (int i = 0; i < 100; i++) {
+    packed += dbl(i * 0.5);
+    appendf(&expected, "  %" PRIu32 ":%g\n", dbl_fn, i * 0.5);
+  }
+  expected += LINE("]") LINE(">");
+  run_decoder(cat( tag(dbl_fn, UPB_WIRE_TYPE_DELIMITED), delim(packed) ),
+              &expected);
+
+  // A packed fixed-width field whose length isn't a multiple of the value
+  // size is an error.
+  uint32_t flt_fn = rep_fn(UPB_DESCRIPTOR_TYPE_FLOAT);
+  assert_does_not_parse(
+      cat( tag(flt_fn, UPB_WIRE_TYPE_DELIMITED),
+           delim(cat( flt(1), string("\x01\x02")))) );
+
+  // Truncated and overlong varints inside a packed run are still errors.
+  uint32_t int32_fn = rep_fn(UPB_DESCRIPTOR_TYPE_INT32);
+  assert_does_not_parse(
+      cat( tag(int32_fn, UPB_WIRE_TYPE_DELIMITED),
+           delim(cat( varint(1), string("\x80")))) );
+  assert_does_not_parse(
+      cat( tag(int32_fn, UPB_WIRE_TYPE_DELIMITED),
+           delim(cat( varint(1), string(10, '\x80'), string("\x01")))) );
+
+  global_handlers = old_handlers;
+  global_method = old_method;
+}
+
+int buffer_pins;
+upb::BufferPin string_pin;
+const char* pinned_string;
+
+void count_buffer_pins(void* ud, bool pin) {
+  UPB_UNUSED(ud);
+  buffer_pins += pin ? 1 : -1;
+}
+
+size_t pin_string(int* depth, const uint32_t* num, const char* buf, size_t n,
+                  const upb::BufferHandle* handle) {
+  UPB_UNUSED(depth);
+  UPB_UNUSED(num);
+  ASSERT(handle);
+  ASSERT(!string_pin.held());
+  ASSERT(handle->Pin(&string_pin));
+  pinned_string = buf;
+  return n;
+}
+
+// A string handler can pin the caller's buffer and keep using the string after
+// the decoder has returned.
+void test_pinned_strings(bool allowjit) {
+  upb::reffed_ptr<upb::MessageDef> md = upb::MessageDef::New();
+  ASSERT(md->set_full_name("PinTest", NULL));
+  AddField(UPB_DESCRIPTOR_TYPE_BYTES, "f_bytes", 1, false, md.get());
+  ASSERT(md->Freeze(NULL));
+
+  upb::reffed_ptr<upb::Handlers> h(upb::Handlers::New(md.get()));
+  const upb::FieldDef* f = md->FindFieldByNumber(1);
+  ASSERT(h->SetStringHandler(f, UpbBind(pin_string, new uint32_t(1))));
+  ASSERT(h->Freeze(NULL));
+  upb::reffed_ptr<const upb::pb::DecoderMethod> method =
+      NewMethod(h.get(), allowjit);
+
+  const string payload(100, 'x');
+  string proto = cat( tag(1, UPB_WIRE_TYPE_DELIMITED), delim(payload) );
+  char* buf = new char[proto.size()];
+  memcpy(buf, proto.data(), proto.size());
+
+  upb::Environment env;
+  upb::Sink sink(h.get(), &closures[0]);
+  upb::pb::Decoder* decoder = CreateDecoder(&env, method.get(), &sink);
+  upb::BufferHandle handle;
+  handle.SetPinFunc(&count_buffer_pins, NULL);
+  void* subc;
+  buffer_pins = 0;
+  ASSERT(decoder->input()->Start(proto.size(), &subc));
+  ASSERT(decoder->input()->PutBuffer(subc, buf, proto.size(), &handle) ==
+         proto.size());
+  ASSERT(decoder->input()->End());
+
+  ASSERT(buffer_pins == 1);
+  ASSERT(pinned_string == buf + proto.size() - payload.size());
+  ASSERT(memcmp(pinned_string, payload.data(), payload.size()) == 0);
+  string_pin.Release();
+  ASSERT(buffer_pins == 0);
+  delete[] buf;
+}
+
+// Decodes "proto" in one buffer and returns the handlers' output.
+string decode_all(const upb::pb::DecoderMethod* method, const string& proto) {
+  VerboseParserEnvironment env(filter_hash != 0);
+  upb::Sink sink(method->dest_handlers(), &closures[0]);
+  upb::pb::Decoder* decoder = CreateDecoder(env.env(), method, &sink);
+  env.ResetBytesSink(decoder->input());
+  env.Reset(proto.data(), proto.size(), true, false);
+  output.clear();
+  ASSERT(env.Start());
+  ASSERT(env.ParseBuffer(-1));
+  ASSERT(env.End());
+  ASSERT(env.CheckConsistency());
+  return output;
+}
+
+// With lazy decoding, a lazy submessage field goes to its string handlers
+// undecoded, and can be decoded later with the method compiled for it.
+void test_lazy_submsgs(bool allowjit) {
+  upb::reffed_ptr<upb::MessageDef> inner_md = upb::MessageDef::New();
+  ASSERT(inner_md->set_full_name("LazyInner", NULL));
+  AddField(UPB_DESCRIPTOR_TYPE_INT32, "f_int32", 1, false, inner_md.get());
+  ASSERT(inner_md->Freeze(NULL));
+
+  upb::reffed_ptr<upb::MessageDef> md = upb::MessageDef::New();
+  ASSERT(md->set_full_name("LazyOuter", NULL));
+  AddField(UPB_DESCRIPTOR_TYPE_INT32, "f_int32", 1, false, md.get());
+  upb::reffed_ptr<upb::FieldDef> f = upb::FieldDef::New();
+  ASSERT(f->set_name("f_lazy", NULL));
+  ASSERT(f->set_number(2, NULL));
+  f->set_descriptor_type(UPB_DESCRIPTOR_TYPE_MESSAGE);
+  f->set_lazy(true);
+  ASSERT(f->set_message_subdef(inner_md.get(), NULL));
+  ASSERT(md->AddField(f.get(), NULL));
+  ASSERT(md->Freeze(NULL));
+
+  upb::reffed_ptr<upb::Handlers> inner_h(upb::Handlers::New(inner_md.get()));
+  inner_h->SetStartMessageHandler(UpbMakeHandler(startmsg));
+  inner_h->SetEndMessageHandler(UpbMakeHandler(endmsg));
+  doreg<int32_t, value_int32>(inner_h.get(), 1);
+
+  upb::reffed_ptr<upb::Handlers> h(upb::Handlers::New(md.get()));
+  h->SetStartMessageHandler(UpbMakeHandler(startmsg));
+  h->SetEndMessageHandler(UpbMakeHandler(endmsg));
+  doreg<int32_t, value_int32>(h.get(), 1);
+  ASSERT(h->SetStartSubMessageHandler(f.get(), UpbBind(startsubmsg,
+                                                       new uint32_t(2))));
+  ASSERT(h->SetEndSubMessageHandler(f.get(), UpbBind(endsubmsg,
+                                                     new uint32_t(2))));
+  ASSERT(h->SetSubHandlers(f.get(), inner_h.get()));
+  ASSERT(h->SetStartStringHandler(f.get(), UpbBind(startstr, new uint32_t(2))));
+  ASSERT(h->SetStringHandler(f.get(), UpbBind(value_string, new uint32_t(2))));
+  ASSERT(h->SetEndStringHandler(f.get(), UpbBind(endstr, new uint32_t(2))));
+  upb::Handlers* handlers[] = {h.get(), inner_h.get()};
+  ASSERT(upb::Handlers::Freeze(handlers, 2, NULL));
+
+  string inner = cat( tag(1, UPB_WIRE_TYPE_VARINT), varint(7) );
+  string proto = cat( tag(1, UPB_WIRE_TYPE_VARINT), varint(5),
+                      tag(2, UPB_WIRE_TYPE_DELIMITED), delim(inner) );
+
+  // Without lazy decoding the submessage is decoded as usual.
+  upb::reffed_ptr<const upb::pb::DecoderMethod> method =
+      NewMethod(h.get(), allowjit);
+  string eager = decode_all(method.get(), proto);
+  if (test_mode == ALL_HANDLERS) {
+    ASSERT(eager == LINE("<") LINE("1:5") LINE("2:{") LINE("  <")
+                    LINE("  1:7") LINE("  >") LINE("}") LINE(">"));
+  }
+
+  method = NewMethod(h.get(), allowjit, true);
+  string lazy = decode_all(method.get(), proto);
+  if (test_mode == ALL_HANDLERS) {
+    ASSERT(lazy == cat( LINE("<") LINE("1:5") "2:(2)\"", inner,
+                        LINE("\"") LINE(">") ));
+  }
+
+  const upb::pb::DecoderMethod* sub_method = method->FindSubMethod(f.get());
+  ASSERT(sub_method);
+  ASSERT(sub_method->dest_handlers() == inner_h.get());
+  ASSERT(!method->FindSubMethod(md->FindFieldByNumber(1)));
+  string later = decode_all(sub_method, inner);
+  if (test_mode == ALL_HANDLERS) {
+    ASSERT(later == LINE("<") LINE("1:7") LINE(">"));
+  }
+}
+
+// Decodes "proto" in two buffers, split at every possible point, and checks
+// that the decoder accepts it iff "valid".  Returns the output, which for valid
+// input has to be the same wherever it was split.
+string decode_splits(const upb::pb::DecoderMethod* method, const string& proto,
+                     bool valid) {
+  string ret;
+  for (size_t i = 0; i <= proto.size(); i++) {
+    VerboseParserEnvironment env(filter_hash != 0);
+    upb::Sink sink(method->dest_handlers(), &closures[0]);
+    upb::pb::Decoder* decoder = CreateDecoder(env.env(), method, &sink);
+    env.ResetBytesSink(decoder->input());
+    env.Reset(proto.data(), proto.size(), true, !valid);
+    output.clear();
+    bool ok = env.Start() &&
+              parse(&env, *decoder, i) &&
+              parse(&env, *decoder, -1) &&
+              env.End();
+    ASSERT(env.CheckConsistency());
+    ASSERT(ok == valid);
+    if (valid && i > 0) ASSERT(output == ret);
+    ret = output;
+  }
+  return ret;
+}
+
+// Nesting deeper than the default limit works once the limit is raised; the
+// stacks grow as the nesting is seen.
+void test_deep_nesting(bool allowjit) {
+  upb::reffed_ptr<upb::MessageDef> md = upb::MessageDef::New();
+  ASSERT(md->set_full_name("Deep", NULL));
+  upb::reffed_ptr<upb::FieldDef> f = upb::FieldDef::New();
+  ASSERT(f->set_name("f_message", NULL));
+  ASSERT(f->set_number(1, NULL));
+  f->set_descriptor_type(UPB_DESCRIPTOR_TYPE_MESSAGE);
+  ASSERT(f->set_message_subdef(md.get(), NULL));
+  ASSERT(md->AddField(f.get(), NULL));
+  ASSERT(md->Freeze(NULL));
+
+  upb::reffed_ptr<upb::Handlers> h(upb::Handlers::New(md.get()));
+  h->SetStartMessageHandler(UpbMakeHandler(startmsg));
+  h->SetEndMessageHandler(UpbMakeHandler(endmsg));
+  ASSERT(h->SetSubHandlers(f.get(), h.get()));
+  ASSERT(h->Freeze(NULL));
+  upb::reffed_ptr<const upb::pb::DecoderMethod> method =
+      NewMethod(h.get(), allowjit);
+
+  const int depth = 1000;
+  string buf;
+  for (int i = 0; i < depth - 1; i++) {
+    buf = cat( tag(1, UPB_WIRE_TYPE_DELIMITED), delim(buf) );
+  }
+
+  // Too deep for the default limit.
+  {
+    upb::Environment env;
+    upb::Sink sink(h.get(), &closures[0]);
+    upb::pb::Decoder* decoder =
+        upb::pb::Decoder::Create(&env, method.get(), &sink);
+    ASSERT(decoder->max_nesting() == 64);
+    ASSERT(!upb::BufferSource::PutBuffer(buf, decoder->input()));
+  }
+
+  // Fits exactly once the limit is raised, and fails one past it.
+  for (int extra = 0; extra <= 1; extra++) {
+    string proto = extra ? cat( tag(1, UPB_WIRE_TYPE_DELIMITED), delim(buf) )
+                         : buf;
+    upb::Environment env;
+    upb::Sink sink(h.get(), &closures[0]);
+    upb::pb::Decoder* decoder =
+        upb::pb::Decoder::Create(&env, method.get(), &sink);
+    ASSERT(decoder->set_max_nesting(depth));
+    ASSERT(decoder->max_nesting() == depth);
+    output.clear();
+    bool ok = upb::BufferSource::PutBuffer(proto, decoder->input());
+    ASSERT(ok == !extra);
+    if (ok) {
+      string expected;
+      for (int i = 0; i < depth; i++) expected.append("<\n");
+      for (int i = 0; i < depth; i++) expected.append(">\n");
+      ASSERT(output == expected);
+    }
+  }
+
+  // Lowering the limit again applies to the stack that has already grown.
+  {
+    upb::Environment env;
+    upb::Sink sink(h.get(), &closures[0]);
+    upb::pb::Decoder* decoder =
+        upb::pb::Decoder::Create(&env, method.get(), &sink);
+    ASSERT(decoder->set_max_nesting(depth));
+    ASSERT(upb::BufferSource::PutBuffer(buf, decoder->input()));
+    ASSERT(decoder->set_max_nesting(depth / 2));
+    decoder->Reset();
+    ASSERT(!upb::BufferSource::PutBuffer(buf, decoder->input()));
+  }
+}
+
+// With UTF-8 verification, the string fields of proto3 messages must be valid
+// UTF-8, however the input is split into buffers.  Bytes fields, and strings
+// of proto2 messages, are never checked.
+void test_utf8(bool allowjit) {
+  upb::reffed_ptr<upb::MessageDef> md3 = upb::MessageDef::New();
+  upb::reffed_ptr<upb::MessageDef> md2 = upb::MessageDef::New();
+  upb::MessageDef* mds[] = {md3.get(), md2.get()};
+  ASSERT(md3->set_full_name("Utf8Proto3", NULL));
+  ASSERT(md2->set_full_name("Utf8Proto2", NULL));
+  md3->setsyntax(UPB_SYNTAX_PROTO3);
+  ASSERT(md2->syntax() == UPB_SYNTAX_PROTO2);
+
+  upb::reffed_ptr<upb::Handlers> h3;
+  upb::reffed_ptr<upb::Handlers> h2;
+  upb::Handlers* hs[2];
+  for (int i = 0; i < 2; i++) {
+    AddField(UPB_DESCRIPTOR_TYPE_STRING, "f_string", 1, false, mds[i]);
+    AddField(UPB_DESCRIPTOR_TYPE_BYTES, "f_bytes", 2, false, mds[i]);
+    AddField(UPB_DESCRIPTOR_TYPE_STRING, "r_string", 3, true, mds[i]);
+    ASSERT(mds[i]->Freeze(NULL));
+  }
+  h3 = upb::Handlers::New(md3.get());
+  h2 = upb::Handlers::New(md2.get());
+  hs[0] = h3.get();
+  hs[1] = h2.get();
+  for (int i = 0; i < 2; i++) {
+    hs[i]->SetStartMessageHandler(UpbMakeHandler(startmsg));
+    hs[i]->SetEndMessageHandler(UpbMakeHandler(endmsg));
+    reg_str(hs[i], 1);
+    reg_str(hs[i], 2);
+    reg_str(hs[i], 3);
+  }
+  ASSERT(upb::Handlers::Freeze(hs, 2, NULL));
+
+  upb::pb::CodeCache cache;
+  cache.set_allow_jit(allowjit);
+  upb::pb::DecoderMethodOptions opts(h3.get());
+  opts.set_verify_utf8(true);
+  const upb::pb::DecoderMethod* verify3 = cache.GetDecoderMethod(opts);
+  ASSERT(!verify3->is_native());
+  upb::pb::DecoderMethodOptions opts2(h2.get());
+  opts2.set_verify_utf8(true);
+  const upb::pb::DecoderMethod* verify2 = cache.GetDecoderMethod(opts2);
+  upb::reffed_ptr<const upb::pb::DecoderMethod> plain3 =
+      NewMethod(h3.get(), allowjit);
+
+  const char* valid[] = {
+    "",
+    "plain ASCII that is long enough to be checked sixteen bytes at a time",
+    "\x7f \xc2\x80 \xdf\xbf \xe0\xa0\x80 \xed\x9f\xbf \xee\x80\x80 \xef\xbf\xbf",
+    "\xf0\x90\x80\x80 \xf4\x8f\xbf\xbf",
+    "caf\xc3\xa9, na\xc3\xafve, \xe2\x9c\x93 and \xf0\x9d\x84\x9e after ASCII",
+  };
+  const char* invalid[] = {
+    "\x80",                      // Continuation byte without a lead byte.
+    "\xc0\xaf",                  // Overlong.
+    "\xc1\xbf",                  // Overlong.
+    "\xe0\x80\xaf",              // Overlong.
+    "\xf0\x80\x80\xaf",          // Overlong.
+    "\xed\xa0\x80",              // Surrogate.
+    "\xf4\x90\x80\x80",          // Beyond U+10FFFF.
+    "\xf5\x80\x80\x80",          // Beyond U+10FFFF.
+    "\xff",
+    "\xe2\x82",                  // Truncated by the end of the string.
+    "\xc3\x28",                  // Missing continuation byte.
+    "sixteen bytes of ASCII, and then: \xe2\x28\xa1",
+  };
+
+  for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+    string str(valid[i]);
+    string proto = cat( tag(1, UPB_WIRE_TYPE_DELIMITED), delim(str),
+                        tag(3, UPB_WIRE_TYPE_DELIMITED), delim(str),
+                        tag(3, UPB_WIRE_TYPE_DELIMITED), delim(str) );
+    string out = decode_splits(verify3, proto, true);
+    ASSERT(out == decode_splits(plain3.get(), proto, true));
+    ASSERT(out.find(str) != string::npos);
+  }
+
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    string str(invalid[i]);
+    string ok = cat( tag(1, UPB_WIRE_TYPE_DELIMITED), delim("ok") );
+    decode_splits(verify3, cat( tag(1, UPB_WIRE_TYPE_DELIMITED), delim(str) ),
+                  false);
+    // A bad character can't be completed by the next string.
+    decode_splits(verify3,
+                  cat( tag(3, UPB_WIRE_TYPE_DELIMITED), delim(str),
+                       tag(3, UPB_WIRE_TYPE_DELIMITED), delim("\xa1\xa1") ),
+                  false);
+
+    // Not checked: bytes fields, proto2 messages, or without the option.
+    string bytes = cat( tag(2, UPB_WIRE_TYPE_DELIMITED), delim(str), ok );
+    decode_splits(verify3, bytes, true);
+    string proto = cat( tag(1, UPB_WIRE_TYPE_DELIMITED), delim(str), ok );
+    decode_splits(verify2, proto, true);
+    decode_splits(plain3.get(), proto, true);
+  }
+}
+
+// A field mask limits decoding to the selected fields; everything else is
+// skipped, including whole submessages and groups.
+void test_field_mask(bool allowjit) {
+  const upb::MessageDef* md = global_handlers->message_def();
+  const upb::FieldDef* mask[] = {
+    md->FindFieldByNumber(UPB_DESCRIPTOR_TYPE_MESSAGE),
+    md->FindFieldByNumber(UPB_DESCRIPTOR_TYPE_INT32),
+    md->FindFieldByNumber(UPB_DESCRIPTOR_TYPE_MESSAGE),  // Duplicates are ok.
+  };
+  upb::pb::CodeCache cache;
+  cache.set_allow_jit(allowjit);
+  upb::pb::DecoderMethodOptions opts(global_handlers);
+  opts.set_field_mask(mask, 3);
+  const upb::pb::DecoderMethod* method = cache.GetDecoderMethod(opts);
+  ASSERT(method);
+
+  // The same set of fields in another order finds the same method.
+  const upb::FieldDef* reordered[] = {mask[1], mask[0]};
+  upb::pb::DecoderMethodOptions reordered_opts(global_handlers);
+  reordered_opts.set_field_mask(reordered, 2);
+  ASSERT(cache.GetDecoderMethod(reordered_opts) == method);
+  ASSERT(cache.misses() == 1);
+  upb::pb::DecoderMethodOptions all_opts(global_handlers);
+  ASSERT(cache.GetDecoderMethod(all_opts) != method);
+
+  const upb::pb::DecoderMethod* old_method = global_method;
+  global_method = method;
+
+  string masked_out = cat(
+      tag(UPB_DESCRIPTOR_TYPE_INT64, UPB_WIRE_TYPE_VARINT), varint(44),
+      tag(UPB_DESCRIPTOR_TYPE_STRING, UPB_WIRE_TYPE_DELIMITED), delim("abc"),
+      tag(rep_fn(UPB_DESCRIPTOR_TYPE_INT32), UPB_WIRE_TYPE_DELIMITED),
+          delim(cat( varint(1), varint(2) )),
+      group(UPB_DESCRIPTOR_TYPE_GROUP,
+            cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                 varint(3) )),
+      submsg(rep_fn(UPB_DESCRIPTOR_TYPE_MESSAGE),
+             cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                  varint(4) )) );
+  string inner = cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                      varint(1), masked_out );
+  string proto = cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                      varint(33), masked_out,
+                      submsg(UPB_DESCRIPTOR_TYPE_MESSAGE, inner) );
+  string expected = LINE("<") LINE("5:33") LINE("11:{") LINE("  <")
+                    LINE("  5:1") LINE("  >") LINE("}") LINE(">");
+  run_decoder(proto, &expected);
+
+  global_method = old_method;
+
+  // Bytecode images are compiled without a mask.
+  upb::Status status;
+  ASSERT(!upb::pb::DecoderMethod::Save(opts, "/dev/null", &status));
+  ASSERT(!status.ok());
+}
+
+// With early exit, a message ends as soon as its needed fields have been seen.
+void test_early_exit(bool allowjit) {
+  const upb::MessageDef* md = global_handlers->message_def();
+  const upb::FieldDef* mask[] = {
+    md->FindFieldByNumber(UPB_DESCRIPTOR_TYPE_MESSAGE),
+    md->FindFieldByNumber(UPB_DESCRIPTOR_TYPE_INT32),
+  };
+  upb::pb::CodeCache cache;
+  cache.set_allow_jit(allowjit);
+  upb::pb::DecoderMethodOptions opts(global_handlers);
+  opts.set_field_mask(mask, 2);
+  const upb::pb::DecoderMethod* masked = cache.GetDecoderMethod(opts);
+  opts.set_early_exit(true);
+  const upb::pb::DecoderMethod* method = cache.GetDecoderMethod(opts);
+  ASSERT(method && method != masked);
+  // The JIT doesn't support early exit.
+  ASSERT(!method->is_native());
+
+  const upb::pb::DecoderMethod* old_method = global_method;
+  global_method = method;
+
+  // Field number 0 is an error if we ever get to parse it.
+  string garbage = cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                        varint(99), tag(0, UPB_WIRE_TYPE_VARINT), varint(0) );
+  string innermost = cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                          varint(3) );
+  string inner = cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                      varint(2),
+                      submsg(UPB_DESCRIPTOR_TYPE_MESSAGE, innermost),
+                      garbage );
+  string proto = cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                      varint(1),
+                      tag(UPB_DESCRIPTOR_TYPE_STRING, UPB_WIRE_TYPE_DELIMITED),
+                      delim("abc"),
+                      submsg(UPB_DESCRIPTOR_TYPE_MESSAGE, inner),
+                      garbage, string(100, '\xff') );
+  string expected = LINE("<") LINE("5:1") LINE("11:{") LINE("  <")
+                    LINE("  5:2") LINE("  11:{") LINE("    <") LINE("    5:3")
+                    LINE("    >") LINE("  }") LINE("  >") LINE("}") LINE(">");
+  run_decoder(proto, &expected);
+
+  // Errors before the needed fields have all been seen are still caught.
+  run_decoder(cat( tag(0, UPB_WIRE_TYPE_VARINT), varint(0),
+                   tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                   varint(1) ),
+              NULL);
+
+  global_method = old_method;
+}
+
+// A delimited stream delivers each of its records as a message of its own.
+void test_delimited_stream(bool allowjit) {
+  upb::reffed_ptr<const upb::pb::DecoderMethod> method =
+      NewMethod(global_handlers, allowjit);
+  if (method->is_native()) {
+    upb::Environment env;
+    upb::Sink sink(global_handlers, &closures[0]);
+    upb::pb::Decoder* decoder = CreateDecoder(&env, method.get(), &sink);
+    ASSERT(!decoder->set_delimited(true));
+    ASSERT(!decoder->delimited());
+    return;
+  }
+
+  const upb::pb::DecoderMethod* old_method = global_method;
+  global_method = method.get();
+
+  string record1 = cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                        varint(1) );
+  string record3 = cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                        varint(2),
+                        submsg(UPB_DESCRIPTOR_TYPE_MESSAGE, record1) );
+  string stream = cat( delim(record1), delim(""), delim(record3) );
+  string expected = LINE("<") LINE("5:1") LINE(">")
+                    LINE("<") LINE(">")
+                    LINE("<") LINE("5:2") LINE("11:{") LINE("  <")
+                    LINE("  5:1") LINE("  >") LINE("}") LINE(">");
+  run_decoder(stream, &expected, true);
+
+  // The stream can't end inside a record or its length.
+  run_decoder(cat( delim(record1), varint(record1.size()) ), NULL, true);
+  run_decoder(cat( delim(record1), varint(10), record1 ), NULL, true);
+  run_decoder(cat( delim(record1), "\x80" ), NULL, true);
+
+  // A record can't end in the middle of a field.
+  run_decoder(delim(cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                         "\x80" )),
+              NULL, true);
+
+  global_method = old_method;
+}
+
+bool row_int32(std::vector<int32_t>* rows, int32_t val) {
+  rows->push_back(val);
+  return true;
+}
+
+struct ParallelRows {
+  const upb::Handlers* handlers;
+  // A deque, so that the batches don't move as more are added.
+  std::deque<std::vector<int32_t> > batches;
+  std::vector<int32_t> merged;
+  size_t fail_merge_at;
+};
+
+bool parallel_sink(void* closure, size_t batch, upb::Sink* sink) {
+  ParallelRows* rows = static_cast<ParallelRows*>(closure);
+  ASSERT(batch == rows->batches.size());
+  rows->batches.push_back(std::vector<int32_t>());
+  sink->Reset(rows->handlers, &rows->batches.back());
+  return true;
+}
+
+bool parallel_merge(void* closure, size_t batch) {
+  ParallelRows* rows = static_cast<ParallelRows*>(closure);
+  if (batch == rows->fail_merge_at) return false;
+  ASSERT(rows->merged.size() == batch * 7);
+  rows->merged.insert(rows->merged.end(), rows->batches[batch].begin(),
+                      rows->batches[batch].end());
+  return true;
+}
+
+bool decode_parallel(const upb::pb::DecoderMethod* method, const string& proto,
+                     size_t threads, ParallelRows* rows) {
+  const upb::FieldDef* f = global_handlers->message_def()->FindFieldByNumber(
+      rep_fn(UPB_DESCRIPTOR_TYPE_MESSAGE));
+  upb::pb::ParallelDecodeOptions opts(method, f);
+  opts.set_threads(threads);
+  opts.set_batch_size(7);
+  opts.set_callbacks(&parallel_sink, &parallel_merge, rows);
+  upb::Status status;
+  bool ok = upb::pb::Decoder::DecodeParallel(opts, proto.data(), proto.size(),
+                                             &status);
+  ASSERT(ok == status.ok());
+  return ok;
+}
+
+// The elements of a repeated submessage field can be decoded in batches on
+// several threads, and are merged back in order.
+void test_parallel_decode(bool allowjit) {
+  const upb::MessageDef* md = global_handlers->message_def();
+  upb::reffed_ptr<upb::Handlers> h(upb::Handlers::New(md));
+  ASSERT(h->SetInt32Handler(md->FindFieldByNumber(UPB_DESCRIPTOR_TYPE_INT32),
+                            UpbMakeHandler(row_int32)));
+  ASSERT(h->Freeze(NULL));
+  upb::reffed_ptr<const upb::pb::DecoderMethod> method =
+      NewMethod(h.get(), allowjit);
+
+  // Other fields of the top-level message, including groups that contain
+  // fields with the same number, are skipped.
+  string other = cat(
+      tag(UPB_DESCRIPTOR_TYPE_INT64, UPB_WIRE_TYPE_VARINT), varint(44),
+      tag(UPB_DESCRIPTOR_TYPE_FIXED64, UPB_WIRE_TYPE_64BIT), uint64(55),
+      group(UPB_DESCRIPTOR_TYPE_GROUP,
+            submsg(rep_fn(UPB_DESCRIPTOR_TYPE_MESSAGE),
+                   cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                        varint(66) ))) );
+  string proto;
+  const int32_t kRows = 1000;
+  for (int32_t i = 0; i < kRows; i++) {
+    if (i % 100 == 0) proto += other;
+    proto += submsg(rep_fn(UPB_DESCRIPTOR_TYPE_MESSAGE),
+                    cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                         varint(i) ));
+  }
+
+  for (size_t threads = 1; threads <= 4; threads += 3) {
+    ParallelRows rows;
+    rows.handlers = h.get();
+    rows.fail_merge_at = SIZE_MAX;
+    ASSERT(decode_parallel(method.get(), proto, threads, &rows));
+    ASSERT(rows.batches.size() == (kRows + 6) / 7);
+    ASSERT(rows.merged.size() == (size_t)kRows);
+    for (int32_t i = 0; i < kRows; i++) {
+      ASSERT(rows.merged[i] == i);
+    }
+
+    // A failed merge stops decoding.
+    rows.batches.clear();
+    rows.merged.clear();
+    rows.fail_merge_at = 3;
+    ASSERT(!decode_parallel(method.get(), proto, threads, &rows));
+    ASSERT(rows.merged.size() == 3 * 7);
+
+    // So does a malformed element.
+    rows.batches.clear();
+    rows.merged.clear();
+    rows.fail_merge_at = SIZE_MAX;
+    ASSERT(!decode_parallel(
+        method.get(),
+        cat( proto, submsg(rep_fn(UPB_DESCRIPTOR_TYPE_MESSAGE), "\x08") ),
+        threads, &rows));
+
+    // The scan catches a truncated top-level message before decoding starts.
+    rows.batches.clear();
+    ASSERT(!decode_parallel(method.get(), proto.substr(0, proto.size() - 1),
+                            threads, &rows));
+    ASSERT(rows.batches.empty());
+  }
+
+  // The callbacks are required.
+  const upb::FieldDef* f =
+      md->FindFieldByNumber(rep_fn(UPB_DESCRIPTOR_TYPE_MESSAGE));
+  upb::pb::ParallelDecodeOptions opts(method.get(), f);
+  upb::Status status;
+  ASSERT(!upb::pb::Decoder::DecodeParallel(opts, proto.data(), proto.size(),
+                                           &status));
+  ASSERT(!status.ok());
+}
+
+size_t value_unknown(int* depth, const char* buf, size_t n,
+                     const upb::BufferHandle* handle) {
+  UPB_UNUSED(depth);
+  ASSERT(handle == NULL || handle == &global_handle);
+  output.append(buf, n);
+  return n;
+}
+
+// Unknown fields are handed to the unknown handler byte-for-byte, wherever the
+// input is split.
+void test_unknown_fields(bool allowjit) {
+  upb::reffed_ptr<upb::MessageDef> md = upb::MessageDef::New();
+  ASSERT(md->set_full_name("UnknownTest", NULL));
+  AddField(UPB_DESCRIPTOR_TYPE_INT32, "f_int32", 1, false, md.get());
+  ASSERT(md->Freeze(NULL));
+
+  upb::reffed_ptr<upb::Handlers> h(upb::Handlers::New(md.get()));
+  h->SetStartMessageHandler(UpbMakeHandler(startmsg));
+  h->SetEndMessageHandler(UpbMakeHandler(endmsg));
+  doreg<int32_t, value_int32>(h.get(), 1);
+  ASSERT(h->SetUnknownHandler(UpbMakeHandler(value_unknown)));
+  ASSERT(h->Freeze(NULL));
+  upb::reffed_ptr<const upb::pb::DecoderMethod> method =
+      NewMethod(h.get(), allowjit);
+  // Groups that capture unknown fields always run in the interpreter.
+  ASSERT(!method->is_native());
+
+  const upb::Handlers* old_handlers = global_handlers;
+  const upb::pb::DecoderMethod* old_method = global_method;
+  global_handlers = h.get();
+  global_method = method.get();
+
+  string unknown1 = cat( tag(2, UPB_WIRE_TYPE_VARINT), varint(UINT64_MAX),
+                         tag(3, UPB_WIRE_TYPE_32BIT), uint32(0xdeadbeef) );
+  string unknown2 = cat( tag(4, UPB_WIRE_TYPE_64BIT), uint64(0x1234),
+                         tag(5, UPB_WIRE_TYPE_DELIMITED), delim(string(40, 'u')),
+                         tag(6, UPB_WIRE_TYPE_START_GROUP),
+                             tag(1, UPB_WIRE_TYPE_VARINT), varint(7),
+                             tag(7, UPB_WIRE_TYPE_START_GROUP),
+                             tag(7, UPB_WIRE_TYPE_END_GROUP),
+                         tag(6, UPB_WIRE_TYPE_END_GROUP) );
+  string proto = cat( unknown1, tag(1, UPB_WIRE_TYPE_VARINT), varint(5),
+                      unknown2 );
+  string expected = cat( LINE("<"), unknown1, LINE("1:5"), unknown2,
+                         LINE(">") );
+  run_decoder(proto, &expected);
+
+  // A truncated unknown field is still an error.
+  run_decoder(
+      cat( tag(5, UPB_WIRE_TYPE_DELIMITED), varint(10), string(5, 'u') ),
+      NULL);
+
+  global_handlers = old_handlers;
+  global_method = old_method;
+}
+
+void test_codecache(bool allowjit) {
+  upb::pb::CodeCache cache;
+  cache.set_allow_jit(allowjit);
+  ASSERT(cache.hits() == 0);
+  ASSERT(cache.misses() == 0);
+  ASSERT(cache.compiled_bytes() == 0);
+
+  upb::pb::DecoderMethodOptions opts(global_handlers);
+  const upb::pb::DecoderMethod* m1 = cache.GetDecoderMethod(opts);
+  ASSERT(m1);
+  ASSERT(cache.misses() == 1);
+  ASSERT(cache.hits() == 0);
+  size_t compiled = cache.compiled_bytes();
+  ASSERT(compiled > 0);
+
+  // The same handlers and options must not be compiled again.
+  const upb::pb::DecoderMethod* m2 = cache.GetDecoderMethod(opts);
+  ASSERT(m2 == m1);
+  ASSERT(cache.misses() == 1);
+  ASSERT(cache.hits() == 1);
+  ASSERT(cache.compiled_bytes() == compiled);
+
+  // The test handlers are self-recursive, so the submessage handlers were
+  // compiled together with the top-level method.
+  const upb::MessageDef* md = global_handlers->message_def();
+  const upb::FieldDef* f = md->FindFieldByNumber(UPB_DESCRIPTOR_TYPE_MESSAGE);
+  ASSERT(f);
+  const upb::Handlers* sub = global_handlers->GetSubHandlers(f);
+  if (sub) {
+    const upb::pb::DecoderMethod* m3 =
+        cache.GetDecoderMethod(upb::pb::DecoderMethodOptions(sub));
+    ASSERT(m3->dest_handlers() == sub);
+    ASSERT(cache.misses() == 1);
+    ASSERT(cache.hits() == 2);
+  }
+
+  // Different options produce a different method.
+  upb::pb::DecoderMethodOptions lazy_opts(global_handlers);
+  lazy_opts.set_lazy(true);
+  const upb::pb::DecoderMethod* m4 = cache.GetDecoderMethod(lazy_opts);
+  ASSERT(m4 != m1);
+  ASSERT(cache.misses() == 2);
+  ASSERT(cache.GetDecoderMethod(lazy_opts) == m4);
+}
+
+// With a JIT threshold, methods start out interpreted and are JIT compiled once
+// they have decoded enough messages, within the cache's JIT budget.
+void test_codecache_tiers(bool allowjit) {
+  upb::pb::DecoderMethodOptions opts(global_handlers);
+  string proto = cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                      varint(7) );
+  upb::pb::CodeCache eager;
+  eager.set_allow_jit(allowjit);
+  bool jit = eager.GetDecoderMethod(opts)->is_native();
+  ASSERT(jit == (eager.jit_bytes() > 0));
+
+  {
+    upb::pb::CodeCache cache;
+    cache.set_allow_jit(allowjit);
+    ASSERT(cache.set_jit_threshold(3));
+    const upb::pb::DecoderMethod* m = cache.GetDecoderMethod(opts);
+    ASSERT(!m->is_native());
+    ASSERT(!cache.set_jit_threshold(1));
+    string out = decode_all(m, proto);
+    decode_all(m, proto);
+    ASSERT(cache.GetDecoderMethod(opts) == m);
+    decode_all(m, proto);
+
+    const upb::pb::DecoderMethod* hot = cache.GetDecoderMethod(opts);
+    ASSERT(hot->is_native() == jit);
+    ASSERT((hot != m) == jit);
+    ASSERT(cache.jit_bytes() == eager.jit_bytes());
+    ASSERT(cache.GetDecoderMethod(opts) == hot);
+    ASSERT(decode_all(hot, proto) == out);
+    ASSERT(cache.misses() == 1);
+  }
+
+  // Machine code that doesn't fit in the budget is never used, whether it was
+  // compiled right away or after the method got hot.
+  for (size_t threshold = 0; threshold <= 1; threshold++) {
+    upb::pb::CodeCache cache;
+    cache.set_allow_jit(allowjit);
+    ASSERT(cache.set_jit_budget(1));
+    ASSERT(cache.set_jit_threshold(threshold));
+    const upb::pb::DecoderMethod* m = cache.GetDecoderMethod(opts);
+    ASSERT(!m->is_native());
+    decode_all(m, proto);
+    ASSERT(cache.GetDecoderMethod(opts) == m);
+    decode_all(m, proto);
+    ASSERT(cache.GetDecoderMethod(opts) == m);
+    ASSERT(cache.jit_bytes() == 0);
+  }
+}
+
+// Compiles a method for a message that contains the test message, after a
+// method for the test message itself was already compiled.
+void test_codecache_linking(bool allowjit) {
+  upb::reffed_ptr<upb::MessageDef> md = upb::MessageDef::New();
+  ASSERT(md->set_full_name("LinkTest", NULL));
+  upb::reffed_ptr<upb::FieldDef> f = upb::FieldDef::New();
+  ASSERT(f->set_name("sub", NULL));
+  ASSERT(f->set_number(1, NULL));
+  f->set_descriptor_type(UPB_DESCRIPTOR_TYPE_MESSAGE);
+  ASSERT(f->set_message_subdef(global_handlers->message_def(), NULL));
+  ASSERT(md->AddField(f.get(), NULL));
+  ASSERT(md->Freeze(NULL));
+
+  upb::reffed_ptr<upb::Handlers> h(upb::Handlers::New(md.get()));
+  ASSERT(h->SetStartSubMessageHandler(f.get(),
+                                      UpbBind(startsubmsg, new uint32_t(1))));
+  ASSERT(h->SetEndSubMessageHandler(f.get(),
+                                    UpbBind(endsubmsg, new uint32_t(1))));
+  ASSERT(h->SetSubHandlers(f.get(), global_handlers));
+  ASSERT(h->Freeze(NULL));
+
+  upb::pb::DecoderMethodOptions sub_opts(global_handlers);
+  upb::pb::DecoderMethodOptions opts(h.get());
+  string proto = cat(
+      tag(1, UPB_WIRE_TYPE_DELIMITED),
+      delim(cat(tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                varint(33))));
+  string expected = LINE("1:{")
+                    LINE("  <")
+                    LINE("  5:33")
+                    LINE("  >")
+                    LINE("}");
+
+  {
+    upb::pb::CodeCache cache;
+    cache.set_allow_jit(allowjit);
+    ASSERT(cache.GetDecoderMethod(sub_opts));
+    size_t sub_bytes = cache.compiled_bytes();
+    const upb::pb::DecoderMethod* method = cache.GetDecoderMethod(opts);
+    ASSERT(method);
+    ASSERT(cache.misses() == 2);
+
+    if (!allowjit) {
+      // The new group calls into the existing one instead of compiling the
+      // test message again.
+      upb::pb::CodeCache fresh;
+      ASSERT(fresh.GetDecoderMethod(opts));
+      ASSERT(cache.compiled_bytes() - sub_bytes < fresh.compiled_bytes());
+    }
+
+    string out = decode_all(method, proto);
+    if (test_mode == ALL_HANDLERS) ASSERT(out == expected);
+  }
+
+  // Interpreted groups must not link to machine code.  Here the test message
+  // is JIT compiled within the budget, but the outer message doesn't fit and
+  // is interpreted.
+  size_t sub_jit_bytes;
+  {
+    upb::pb::CodeCache eager;
+    eager.set_allow_jit(allowjit);
+    ASSERT(eager.GetDecoderMethod(sub_opts));
+    sub_jit_bytes = eager.jit_bytes();
+  }
+  if (sub_jit_bytes > 0) {
+    upb::pb::CodeCache cache;
+    ASSERT(cache.set_jit_budget(sub_jit_bytes));
+    ASSERT(cache.GetDecoderMethod(sub_opts)->is_native());
+    const upb::pb::DecoderMethod* method = cache.GetDecoderMethod(opts);
+    ASSERT(!method->is_native());
+    ASSERT(cache.jit_bytes() == sub_jit_bytes);
+    string out = decode_all(method, proto);
+    if (test_mode == ALL_HANDLERS) ASSERT(out == expected);
+  }
+
+  // The same when the test message was promoted to machine code after it got
+  // hot, and the outer message starts out interpreted.
+  {
+    upb::pb::CodeCache cache;
+    cache.set_allow_jit(allowjit);
+    ASSERT(cache.set_jit_threshold(1));
+    const upb::pb::DecoderMethod* sub = cache.GetDecoderMethod(sub_opts);
+    ASSERT(!sub->is_native());
+    decode_all(sub, cat( tag(UPB_DESCRIPTOR_TYPE_INT32, UPB_WIRE_TYPE_VARINT),
+                         varint(33) ));
+    ASSERT(cache.GetDecoderMethod(sub_opts)->is_native() ==
+           (sub_jit_bytes > 0));
+    const upb::pb::DecoderMethod* method = cache.GetDecoderMethod(opts);
+    ASSERT(!method->is_native());
+    string out = decode_all(method, proto);
+    if (test_mode == ALL_HANDLERS) ASSERT(out == expected);
+  }
+}
+
+void test_bytecode_image() {
+  char filename[] = "/tmp/upb_test_decoder.XXXXXX";
+  int fd = mkstemp(filename);
+  ASSERT(fd >= 0);
+  close(fd);
+
+  upb::Status status;
+  upb::pb::DecoderMethodOptions opts(global_handlers);
+  ASSERT(upb::pb::DecoderMethod::Save(opts, filename, &status));
+  ASSERT(status.ok());
+
+  upb::pb::CodeCache cache;
+  const upb::pb::DecoderMethod* method =
+      cache.LoadDecoderMethod(opts, filename, &status);
+  ASSERT(method);
+  ASSERT(status.ok());
+  ASSERT(!method->is_native());
+  ASSERT(cache.misses() == 0);
+  ASSERT(cache.compiled_bytes() == 0);
+
+  // Once loaded, the method is cached like a compiled one.
+  ASSERT(cache.GetDecoderMethod(opts) == method);
+  ASSERT(cache.hits() == 1);
+
+  // The loaded method must decode exactly like a compiled one.
+  const upb::pb::DecoderMethod* compiled_method = global_method;
+  global_method = method;
+  test_invalid();
+  test_valid();
+  global_method = compiled_method;
+
+  // An image only loads for the handlers and options it was saved for.
+  upb::pb::DecoderMethodOptions lazy_opts(global_handlers);
+  lazy_opts.set_lazy(true);
+  upb::Status lazy_status;
+  upb::pb::CodeCache lazy_cache;
+  ASSERT(!lazy_cache.LoadDecoderMethod(lazy_opts, filename, &lazy_status));
+  ASSERT(!lazy_status.ok());
+
+  upb::reffed_ptr<const upb::Handlers> other_handlers =
+      NewHandlers(test_mode == ALL_HANDLERS ? NO_HANDLERS : ALL_HANDLERS);
+  upb::pb::DecoderMethodOptions other_opts(other_handlers.get());
+  upb::Status other_status;
+  upb::pb::CodeCache other_cache;
+  ASSERT(!other_cache.LoadDecoderMethod(other_opts, filename, &other_status));
+  ASSERT(!other_status.ok());
+
+  ASSERT(unlink(filename) == 0);
+  upb::Status missing_status;
+  upb::pb::CodeCache missing_cache;
+  ASSERT(!missing_cache.LoadDecoderMethod(opts, filename, &missing_status));
+  ASSERT(!missing_status.ok());
+}
+
+#ifndef UPB_THREAD_UNSAFE
+
+struct CodeCacheThreadArg {
+  upb::pb::CodeCache* cache;
+  const upb::pb::DecoderMethod* method;
+};
+
+void* GetDecoderMethodThread(void* p) {
+  CodeCacheThreadArg* arg = static_cast<CodeCacheThreadArg*>(p);
+  upb::pb::DecoderMethodOptions opts(global_handlers);
+  arg->method = arg->cache->GetDecoderMethod(opts);
+  return NULL;
+}
+
+void test_codecache_threads(bool allowjit) {
+  const int kThreads = 8;
+  upb::pb::CodeCache cache;
+  cache.set_allow_jit(allowjit);
+
+  pthread_t threads[kThreads];
+  CodeCacheThreadArg args[kThreads];
+  for (int i = 0; i < kThreads; i++) {
+    args[i].cache = &cache;
+    args[i].method = NULL;
+    ASSERT(pthread_create(&threads[i], NULL, GetDecoderMethodThread,
+                          &args[i]) == 0);
+  }
+  for (int i = 0; i < kThreads; i++) {
+    ASSERT(pthread_join(threads[i], NULL) == 0);
+  }
+
+  // All threads share a single compiled method.
+  for (int i = 0; i < kThreads; i++) {
+    ASSERT(args[i].method);
+    ASSERT(args[i].method == args[0].method);
+  }
+  ASSERT(cache.misses() == 1);
+  ASSERT(cache.hits() == kThreads - 1);
+}
+
+#endif
+
 void run_tests(bool use_jit) {
   upb::reffed_ptr<const upb::pb::DecoderMethod> method;
   upb::reffed_ptr<const upb::Handlers> handlers;
@@ -1287,6 +2471,26 @@ void run_tests(bool use_jit) {
   test_valid();
 
   test_emptyhandlers(use_jit);
+  test_sparse_fieldnums(use_jit);
+  test_packed_arrays(use_jit);
+  test_pinned_strings(use_jit);
+  test_unknown_fields(use_jit);
+  test_lazy_submsgs(use_jit);
+  test_utf8(use_jit);
+  test_deep_nesting(use_jit);
+  test_field_mask(use_jit);
+  test_early_exit(use_jit);
+  test_delimited_stream(use_jit);
+  test_parallel_decode(use_jit);
+  test_codecache(use_jit);
+  test_codecache_tiers(use_jit);
+  test_codecache_linking(use_jit);
+  if (!use_jit) {
+    test_bytecode_image();
+  }
+#ifndef UPB_THREAD_UNSAFE
+  test_codecache_threads(use_jit);
+#endif
 }
 
 void run_test_suite() {
@@ -1,4 +1,11 @@
 
+#include <stdio.h>
+#include <sys/resource.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <set>
+#include <vector>
+
 #include "tests/upb_test.h"
 #include "upb/bindings/stdc++/string.h"
 #include "upb/descriptor/descriptor.upb.h"
@@ -6,6 +13,15 @@
 #include "upb/pb/encoder.h"
 #include "upb/pb/glue.h"
 
+bool benchmark = false;
+#define CPU_TIME_PER_TEST 0.5
+
+double get_usertime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + (usage.ru_utime.tv_usec/1000000.0);
+}
+
 std::string read_string(const char *filename) {
   size_t len;
   char *str = upb_readfile(filename, &len);
@@ -16,14 +32,28 @@ std::string read_string(const char *filename) {
   return ret;
 }
 
+// Encoder handlers for a message type, and a decoder method that decodes into
+// them, so that messages can be round-tripped through the two.
+struct RoundTrip {
+  // For FileDescriptorSet, which most of these tests round-trip.
+  RoundTrip() {
+    Init(upbdefs::google::protobuf::FileDescriptorSet::MessageDef().get());
+  }
+  explicit RoundTrip(const upb::MessageDef* md) { Init(md); }
+
+  upb::reffed_ptr<const upb::Handlers> encoder_handlers;
+  upb::reffed_ptr<const upb::pb::DecoderMethod> method;
+
+ private:
+  void Init(const upb::MessageDef* md) {
+    encoder_handlers = upb::pb::Encoder::NewHandlers(md);
+    method = upb::pb::DecoderMethod::New(
+        upb::pb::DecoderMethodOptions(encoder_handlers.get()));
+  }
+};
+
 void test_pb_roundtrip() {
-  upb::reffed_ptr<const upb::MessageDef> md(
-      upbdefs::google::protobuf::FileDescriptorSet::MessageDef());
-  upb::reffed_ptr<const upb::Handlers> encoder_handlers(
-      upb::pb::Encoder::NewHandlers(md.get()));
-  upb::reffed_ptr<const upb::pb::DecoderMethod> method(
-      upb::pb::DecoderMethod::New(
-          upb::pb::DecoderMethodOptions(encoder_handlers.get())));
+  RoundTrip rt;
 
   char buf[512];
   upb::SeededAllocator alloc(buf, sizeof(buf));
@@ -33,20 +63,366 @@ void test_pb_roundtrip() {
   std::string output;
   upb::StringSink string_sink(&output);
   upb::pb::Encoder* encoder =
-      upb::pb::Encoder::Create(&env, encoder_handlers.get(),
+      upb::pb::Encoder::Create(&env, rt.encoder_handlers.get(),
                                string_sink.input());
   upb::pb::Decoder* decoder =
-      upb::pb::Decoder::Create(&env, method.get(), encoder->input());
+      upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
   bool ok = upb::BufferSource::PutBuffer(input, decoder->input());
   ASSERT(ok);
   ASSERT(input == output);
 }
 
+// Fields the schema doesn't know about survive a decode/encode round trip.
+void test_pb_roundtrip_unknown() {
+  RoundTrip rt;
+
+  upb::Environment env;
+  // Field 1 (FileDescriptorProto) holding unknown varint, 64-bit, delimited
+  // and group fields, followed by an unknown 32-bit field.
+  const char data[] =
+      "\x0a\x1a"
+      "\xa8\x06\x96\x01"
+      "\xb1\x06\x01\x02\x03\x04\x05\x06\x07\x08"
+      "\xba\x06\x03" "abc"
+      "\xc3\x06" "\x08\x01" "\xc4\x06"
+      "\xcd\x06\x01\x02\x03\x04";
+  std::string input(data, sizeof(data) - 1);
+  std::string output;
+  upb::StringSink string_sink(&output);
+  upb::pb::Encoder* encoder =
+      upb::pb::Encoder::Create(&env, rt.encoder_handlers.get(),
+                               string_sink.input());
+  upb::pb::Decoder* decoder =
+      upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+  bool ok = upb::BufferSource::PutBuffer(input, decoder->input());
+  ASSERT(ok);
+  ASSERT(input == output);
+}
+
+// Two-pass encoding produces the same bytes as the buffering encoder, in a
+// single buffer.
+void test_pb_twopass() {
+  RoundTrip rt;
+
+  upb::Environment env;
+  std::string input = read_string("upb/descriptor/descriptor.pb");
+  std::string output;
+  upb::StringSink string_sink(&output);
+  upb::pb::Encoder* encoder =
+      upb::pb::Encoder::Create(&env, rt.encoder_handlers.get(),
+                               string_sink.input());
+  ASSERT(!encoder->StartWritePass());
+
+  for (int i = 0; i < 2; i++) {
+    encoder->StartSizePass();
+    upb::pb::Decoder* decoder =
+        upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+    ASSERT(upb::BufferSource::PutBuffer(input, decoder->input()));
+    ASSERT(output.empty());
+    ASSERT(encoder->encoded_size() == input.size());
+
+    ASSERT(encoder->StartWritePass());
+    decoder = upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+    ASSERT(upb::BufferSource::PutBuffer(input, decoder->input()));
+    ASSERT(input == output);
+    output.clear();
+  }
+
+  // The encoder goes back to buffering afterwards.
+  upb::pb::Decoder* decoder =
+      upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+  ASSERT(upb::BufferSource::PutBuffer(input, decoder->input()));
+  ASSERT(input == output);
+  output.clear();
+
+  // The second pass must push the message that was measured.
+  std::string other = read_string("tests/test.proto.pb");
+  encoder->StartSizePass();
+  decoder = upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+  ASSERT(upb::BufferSource::PutBuffer(input, decoder->input()));
+  ASSERT(encoder->StartWritePass());
+  decoder = upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+  ASSERT(!upb::BufferSource::PutBuffer(other, decoder->input()));
+  ASSERT(output.empty());
+}
+
+// Writing submessages in place gives the same output, whether or not the
+// length sizes were guessed right.
+void test_pb_speculative() {
+  RoundTrip rt;
+
+  upb::Environment env;
+  std::string inputs[] = {
+    read_string("upb/descriptor/descriptor.pb"),
+    read_string("tests/test.proto.pb"),
+  };
+  std::string output;
+  upb::StringSink string_sink(&output);
+  upb::pb::Encoder* encoder =
+      upb::pb::Encoder::Create(&env, rt.encoder_handlers.get(),
+                               string_sink.input());
+  ASSERT(!encoder->speculative());
+  encoder->set_speculative(true);
+  ASSERT(encoder->speculative());
+
+  // The first message starts from guesses of one byte; the others start from
+  // whatever the message before them needed.
+  for (int i = 0; i < 4; i++) {
+    const std::string& input = inputs[i % 2];
+    upb::pb::Decoder* decoder =
+        upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+    ASSERT(upb::BufferSource::PutBuffer(input, decoder->input()));
+    ASSERT(input == output);
+    output.clear();
+  }
+
+  // Two-pass encoding goes back to speculation afterwards.
+  encoder->StartSizePass();
+  upb::pb::Decoder* decoder =
+      upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+  ASSERT(upb::BufferSource::PutBuffer(inputs[0], decoder->input()));
+  ASSERT(encoder->StartWritePass());
+  decoder = upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+  ASSERT(upb::BufferSource::PutBuffer(inputs[0], decoder->input()));
+  ASSERT(inputs[0] == output);
+  ASSERT(encoder->speculative());
+}
+
+struct IOVecOutput {
+  std::string data;
+  int calls;
+  std::vector<const char*> pieces;
+};
+
+bool put_iovec(void* c, const void* hd, const upb_iovec* iov, size_t n) {
+  IOVecOutput* out = static_cast<IOVecOutput*>(c);
+  UPB_UNUSED(hd);
+  out->calls++;
+  for (size_t i = 0; i < n; i++) {
+    out->data.append(iov[i].base, iov[i].len);
+    out->pieces.push_back(iov[i].base);
+  }
+  return true;
+}
+
+int buffer_pins;
+
+void count_buffer_pins(void* ud, bool pin) {
+  UPB_UNUSED(ud);
+  buffer_pins += pin ? 1 : -1;
+}
+
+// Gathered output hands over each message at once, referring to long strings
+// in the caller's buffer if it can be pinned.
+void test_pb_iovec() {
+  RoundTrip rt;
+
+  // Another file, with a name too long to copy.
+  std::string name(200, 'x');
+  std::string input = read_string("upb/descriptor/descriptor.pb") +
+                      "\x0a\xcb\x01" "\x0a\xc8\x01" + name;
+  std::vector<char> buf(input.begin(), input.end());
+  const char* name_ptr = &buf[buf.size() - name.size()];
+
+  upb::BytesHandler handler;
+  upb_byteshandler_setiovec(&handler, &put_iovec, NULL);
+  IOVecOutput out;
+  out.calls = 0;
+  upb::BytesSink sink(&handler, &out);
+
+  upb::Environment env;
+  upb::pb::Encoder* encoder =
+      upb::pb::Encoder::Create(&env, rt.encoder_handlers.get(), &sink);
+  ASSERT(!encoder->iovec());
+  encoder->set_speculative(true);
+  encoder->set_iovec(true);
+  ASSERT(encoder->iovec());
+  ASSERT(!encoder->speculative());
+
+  upb::pb::Decoder* decoder =
+      upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+  upb::BufferHandle handle;
+  handle.SetPinFunc(&count_buffer_pins, NULL);
+  void* subc;
+  buffer_pins = 0;
+  ASSERT(decoder->input()->Start(buf.size(), &subc));
+  ASSERT(decoder->input()->PutBuffer(subc, &buf[0], buf.size(), &handle) ==
+         buf.size());
+  ASSERT(decoder->input()->End());
+
+  ASSERT(out.data == input);
+  ASSERT(out.calls == 1);
+  ASSERT(std::find(out.pieces.begin(), out.pieces.end(), name_ptr) !=
+         out.pieces.end());
+  ASSERT(buffer_pins == 0);
+
+  // Sinks without an iovec handler get the pieces one by one, and unpinnable
+  // strings are copied.
+  std::string output;
+  upb::StringSink string_sink(&output);
+  encoder = upb::pb::Encoder::Create(&env, rt.encoder_handlers.get(),
+                                     string_sink.input());
+  encoder->set_iovec(true);
+  decoder = upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+  ASSERT(upb::BufferSource::PutBuffer(input, decoder->input()));
+  ASSERT(output == input);
+}
+
+std::string varint(size_t val) {
+  std::string ret;
+  for (; val >= 0x80; val >>= 7) {
+    ret.push_back((char)((val & 0x7f) | 0x80));
+  }
+  ret.push_back((char)val);
+  return ret;
+}
+
+// A field of wire type 2 ("delimited").
+std::string delim(uint32_t fieldnum, const std::string& data) {
+  return varint((fieldnum << 3) | 2) + varint(data.size()) + data;
+}
+
+// Counts allocations, and frees whatever is left when destroyed.
+class CountingAllocator {
+ public:
+  CountingAllocator() : calls(0) {}
+  ~CountingAllocator() {
+    for (std::set<void*>::iterator i = live.begin(); i != live.end(); ++i) {
+      free(*i);
+    }
+  }
+
+  static void* Alloc(void* ud, void* ptr, size_t oldsize, size_t size) {
+    CountingAllocator* a = static_cast<CountingAllocator*>(ud);
+    UPB_UNUSED(oldsize);
+    a->calls++;
+    if (ptr) a->live.erase(ptr);
+    void* ret = realloc(ptr, size);
+    if (ret) a->live.insert(ret);
+    return ret;
+  }
+
+  int calls;
+  std::set<void*> live;
+};
+
+// An encoder can be reused for any number of messages, however deeply they
+// nest, and once its buffers have grown it stops allocating.
+void test_pb_reuse() {
+  RoundTrip rt;
+
+  // A file with DescriptorProto.nested_type (3) nested 1000 deep.
+  const size_t depth = 1000;
+  std::string nested;
+  for (size_t i = 0; i < depth; i++) {
+    nested = delim(3, nested);
+  }
+  std::string inputs[] = {
+    read_string("upb/descriptor/descriptor.pb"),
+    delim(1, delim(4, nested)),
+  };
+
+  CountingAllocator alloc;
+  upb::Environment env;
+  env.SetAllocationFunction(&CountingAllocator::Alloc, &alloc);
+  std::string output;
+  upb::StringSink string_sink(&output);
+  upb::pb::Encoder* encoder =
+      upb::pb::Encoder::Create(&env, rt.encoder_handlers.get(),
+                               string_sink.input());
+  upb::pb::Decoder* decoder =
+      upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+  // Each level is a repeated field and a submessage to the decoder.
+  ASSERT(decoder->set_max_nesting(depth * 2 + 10));
+
+  // Abandon a message halfway.
+  void* subc;
+  ASSERT(decoder->input()->Start(inputs[1].size(), &subc));
+  ASSERT(decoder->input()->PutBuffer(subc, inputs[1].data(),
+                                     inputs[1].size() / 2, NULL) ==
+         inputs[1].size() / 2);
+
+  int calls = 0;
+  for (int i = 0; i < 6; i++) {
+    const std::string& input = inputs[i % 2];
+    decoder->Reset();
+    encoder->Reset();
+    output.clear();
+    ASSERT(upb::BufferSource::PutBuffer(input, decoder->input()));
+    ASSERT(input == output);
+    if (i == 1) {
+      calls = alloc.calls;
+    }
+  }
+  ASSERT(alloc.calls == calls);
+}
+
+// Round-trips each benchmark message through the decoder and the encoder, with
+// both ways of encoding submessages.  Run "make tests/google_messages.proto.pb"
+// and then "tests/pb/test_encoder benchmark".
+void benchmark_roundtrip(const char *msgname, const char *datafile) {
+  upb::reffed_ptr<upb::SymbolTable> symtab(upb::SymbolTable::New());
+  upb::Status status;
+  ASSERT(upb::LoadDescriptorFileIntoSymtab(
+      symtab.get(), "tests/google_messages.proto.pb", &status));
+  const upb::MessageDef* md = symtab->LookupMessage(msgname);
+  ASSERT(md);
+  RoundTrip rt(md);
+  std::string input = read_string(datafile);
+  std::string expected;
+
+  for (int speculative = 0; speculative <= 1; speculative++) {
+    upb::Environment env;
+    std::string output;
+    upb::StringSink string_sink(&output);
+    upb::pb::Encoder* encoder =
+        upb::pb::Encoder::Create(&env, rt.encoder_handlers.get(),
+                                 string_sink.input());
+    encoder->set_speculative(speculative);
+    upb::pb::Decoder* decoder =
+        upb::pb::Decoder::Create(&env, rt.method.get(), encoder->input());
+
+    printf("%s (%s): ", msgname, speculative ? "speculative" : "buffered");
+    fflush(stdout);
+    double before = get_usertime();
+    double total;
+    size_t i;
+    for (i = 0; true; i++) {
+      if ((i & 0x3ff) == 0 &&
+          (total = get_usertime() - before) > CPU_TIME_PER_TEST) {
+        break;
+      }
+      output.clear();
+      decoder->Reset();
+      ASSERT(upb::BufferSource::PutBuffer(input, decoder->input()));
+    }
+    printf("%0.1f MB/s\n", i * input.size() / total / 1000000);
+
+    if (speculative) {
+      ASSERT(output == expected);
+    } else {
+      expected = output;
+    }
+  }
+}
+
 extern "C" {
 int run_tests(int argc, char *argv[]) {
-  UPB_UNUSED(argc);
-  UPB_UNUSED(argv);
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "benchmark") == 0) benchmark = true;
+  }
   test_pb_roundtrip();
+  test_pb_roundtrip_unknown();
+  test_pb_twopass();
+  test_pb_speculative();
+  test_pb_iovec();
+  test_pb_reuse();
+  if (benchmark) {
+    benchmark_roundtrip("benchmarks.SpeedMessage1",
+                        "tests/google_message1.dat");
+    benchmark_roundtrip("benchmarks.SpeedMessage2",
+                        "tests/google_message2.dat");
+  }
   return 0;
 }
 }
@@ -89,6 +89,77 @@ TEST_VARINT_DECODER(check2_branch64)
 TEST_VARINT_DECODER(check2_wright)
 TEST_VARINT_DECODER(check2_massimino)
 
+/* Test that a run of varints decodes the same as decoding them one at a time,
+ * and that it stops cleanly at "max" and before a truncated varint. */
+static void test_vdecode_run() {
+  char buf[256];
+  uint64_t vals[64];
+  uint64_t nums[40];
+  char *starts[40];
+  const char *end;
+  char *p = buf;
+  size_t n;
+  int i;
+
+  for (i = 0; i < 40; i++) {
+    /* Mostly one-byte values, with a few long ones mixed in. */
+    nums[i] = (i % 13 == 12) ? (UINT64_MAX >> i) : (uint64_t)(i * 3);
+    starts[i] = p;
+    p += upb_vencode64(nums[i], p);
+  }
+
+  n = upb_vdecode_run(buf, p, vals, 64, &end);
+  ASSERT(n == 40);
+  ASSERT(end == p);
+  for (i = 0; i < 40; i++) {
+    ASSERT(vals[i] == nums[i]);
+  }
+
+  n = upb_vdecode_run(buf, p, vals, 5, &end);
+  ASSERT(n == 5);
+  ASSERT(upb_vdecode_run(end, p, vals + 5, 64, &end) == 35);
+  ASSERT(end == p);
+  for (i = 0; i < 40; i++) {
+    ASSERT(vals[i] == nums[i]);
+  }
+
+  /* A multi-byte varint that is cut off is left for the caller. */
+  n = upb_vdecode_run(buf, starts[38] + 2, vals, 64, &end);
+  ASSERT(n == 38);
+  ASSERT(end == starts[38]);
+
+  ASSERT(upb_vdecode_run(buf, buf, vals, 64, &end) == 0);
+  ASSERT(end == buf);
+}
+
+/* Test that skipping a varint lands where decoding it would. */
+static void test_vskip_fast() {
+  char buf[16];
+  uint64_t num;
+  size_t bytes;
+  int i;
+
+  for (num = 5; num * 1.5 < UINT64_MAX; num *= 1.5) {
+    memset(buf, 0xff, sizeof(buf));
+    bytes = upb_vencode64(num, buf);
+    ASSERT(upb_vskip_fast(buf) == buf + bytes);
+  }
+  memset(buf, 0xff, sizeof(buf));
+  bytes = upb_vencode64(0, buf);
+  ASSERT(upb_vskip_fast(buf) == buf + bytes);
+
+  /* Every length, with the last byte in each position of either word. */
+  for (i = 0; i < UPB_PB_VARINT_MAX_LEN; i++) {
+    memset(buf, 0x80, sizeof(buf));
+    buf[i] = 1;
+    ASSERT(upb_vskip_fast(buf) == buf + i + 1);
+  }
+
+  /* Unterminated within ten bytes. */
+  memset(buf, 0x80, sizeof(buf));
+  ASSERT(upb_vskip_fast(buf) == NULL);
+}
+
 int run_tests(int argc, char *argv[]) {
   UPB_UNUSED(argc);
   UPB_UNUSED(argv);
@@ -96,6 +167,8 @@ int run_tests(int argc, char *argv[]) {
   test_check2_branch64();
   test_check2_wright();
   test_check2_massimino();
+  test_vdecode_run();
+  test_vskip_fast();
   return 0;
 }
 
@@ -1115,6 +1115,40 @@ void TestHandlerDataDestruction() {
   ASSERT(x == 0);
 }
 
+static void CountPins(void* ud, bool pin) {
+  int* pins = static_cast<int*>(ud);
+  *pins += pin ? 1 : -1;
+}
+
+void TestBufferPin() {
+  int pins = 0;
+  upb::BufferPin pin;
+  {
+    upb::BufferHandle handle;
+    ASSERT(!handle.pinnable());
+    ASSERT(!handle.Pin(&pin));
+    ASSERT(!pin.held());
+
+    handle.SetPinFunc(&CountPins, &pins);
+    ASSERT(handle.pinnable());
+    ASSERT(handle.Pin(&pin));
+    ASSERT(pin.held());
+    ASSERT(pins == 1);
+
+    upb::BufferPin pin2;
+    ASSERT(handle.Pin(&pin2));
+    ASSERT(pins == 2);
+  }
+
+  // The pin outlives both the handle and the other pin.
+  ASSERT(pins == 1);
+  pin.Release();
+  ASSERT(!pin.held());
+  ASSERT(pins == 0);
+  pin.Release();
+  ASSERT(pins == 0);
+}
+
 void TestOneofs() {
   upb::Status status;
   upb::reffed_ptr<upb::MessageDef> md(upb::MessageDef::New());
@@ -1268,6 +1302,8 @@ int run_tests(int argc, char *argv[]) {
 
   TestHandlerDataDestruction();
 
+  TestBufferPin();
+
   TestOneofs();
 
   return 0;
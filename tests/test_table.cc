@@ -303,6 +303,22 @@ void test_delete() {
   upb_inttable_uninit(&t);
 }
 
+// Keys with embedded NULs must be removable by their full length.
+void test_strtable_remove_binary() {
+  upb_strtable t;
+  upb_strtable_init(&t, UPB_CTYPE_INT32);
+  ASSERT(upb_strtable_insert2(&t, "a\0b", 3, upb_value_int32(1)));
+  ASSERT(upb_strtable_insert2(&t, "a\0c", 3, upb_value_int32(2)));
+  upb_value v;
+  ASSERT(upb_strtable_remove2(&t, "a\0b", 3, &v));
+  ASSERT(upb_value_getint32(v) == 1);
+  ASSERT(!upb_strtable_lookup2(&t, "a\0b", 3, &v));
+  ASSERT(upb_strtable_lookup2(&t, "a\0c", 3, &v));
+  ASSERT(upb_value_getint32(v) == 2);
+  ASSERT(upb_strtable_count(&t) == 1);
+  upb_strtable_uninit(&t);
+}
+
 extern "C" {
 
 int run_tests(int argc, char *argv[]) {
@@ -357,6 +373,7 @@ int run_tests(int argc, char *argv[]) {
   delete[] keys4;
 
   test_delete();
+  test_strtable_remove_binary();
 
   return 0;
 }
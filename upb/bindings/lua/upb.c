@@ -1864,6 +1864,7 @@ int luaopen_upb_c(lua_State *L) {
   lupb_setfieldi(L, "HANDLER_ENDSUBMSG",   UPB_HANDLER_ENDSUBMSG);
   lupb_setfieldi(L, "HANDLER_STARTSEQ",    UPB_HANDLER_STARTSEQ);
   lupb_setfieldi(L, "HANDLER_ENDSEQ",      UPB_HANDLER_ENDSEQ);
+  lupb_setfieldi(L, "HANDLER_ARRAY",       UPB_HANDLER_ARRAY);
 
   return 1;  /* Return package table. */
 }
@@ -288,6 +288,7 @@ static bool assign_msg_indices(upb_msgdef *m, upb_status *s) {
     v = upb_value_bool(true);
     upb_inttable_insert(&t, UPB_STARTMSG_SELECTOR, v);
     upb_inttable_insert(&t, UPB_ENDMSG_SELECTOR, v);
+    upb_inttable_insert(&t, UPB_UNKNOWN_SELECTOR, v);
     for(upb_msg_field_begin(&j, m);
         !upb_msg_field_done(&j);
         upb_msg_field_next(&j)) {
@@ -308,6 +309,7 @@ static bool assign_msg_indices(upb_msgdef *m, upb_status *s) {
       TRY(UPB_HANDLER_ENDSUBMSG)
       TRY(UPB_HANDLER_STARTSEQ)
       TRY(UPB_HANDLER_ENDSEQ)
+      TRY(UPB_HANDLER_ARRAY)
     }
     upb_inttable_uninit(&t);
   }
@@ -1324,6 +1326,7 @@ upb_msgdef *upb_msgdef_new(const void *owner) {
   if (!upb_strtable_init(&m->ntoo, UPB_CTYPE_PTR)) goto err1;
   m->map_entry = false;
   m->primitives_have_presence = true;
+  m->syntax = UPB_SYNTAX_PROTO2;
   return m;
 
 err1:
@@ -1347,6 +1350,7 @@ upb_msgdef *upb_msgdef_dup(const upb_msgdef *m, const void *owner) {
                            NULL);
   newm->map_entry = m->map_entry;
   newm->primitives_have_presence = m->primitives_have_presence;
+  newm->syntax = m->syntax;
   UPB_ASSERT_VAR(ok, ok);
   for(upb_msg_field_begin(&i, m);
       !upb_msg_field_done(&i);
@@ -1533,6 +1537,16 @@ bool upb_msgdef_mapentry(const upb_msgdef *m) {
   return m->map_entry;
 }
 
+void upb_msgdef_setsyntax(upb_msgdef *m, upb_syntax_t syntax) {
+  assert(!upb_msgdef_isfrozen(m));
+  assert(syntax == UPB_SYNTAX_PROTO2 || syntax == UPB_SYNTAX_PROTO3);
+  m->syntax = syntax;
+}
+
+upb_syntax_t upb_msgdef_syntax(const upb_msgdef *m) {
+  return m->syntax;
+}
+
 void upb_msg_field_begin(upb_msg_field_iter *iter, const upb_msgdef *m) {
   upb_inttable_begin(iter, &m->itof);
 }
@@ -644,6 +644,12 @@ UPB_END_EXTERN_C
 typedef upb_inttable_iter upb_msg_field_iter;
 typedef upb_strtable_iter upb_msg_oneof_iter;
 
+/* The syntax of the .proto file a message was defined in. */
+typedef enum {
+  UPB_SYNTAX_PROTO2 = 2,
+  UPB_SYNTAX_PROTO3 = 3
+} upb_syntax_t;
+
 #ifdef __cplusplus
 
 /* Structure that describes a single .proto message type.
@@ -762,6 +768,12 @@ class upb::MessageDef {
   void setmapentry(bool map_entry);
   bool mapentry() const;
 
+  /* The syntax of the file this message was defined in.  proto3 requires, for
+   * example, that the values of its string fields are valid UTF-8.  Defaults
+   * to UPB_SYNTAX_PROTO2. */
+  void setsyntax(upb_syntax_t syntax);
+  upb_syntax_t syntax() const;
+
   /* Iteration over fields.  The order is undefined. */
   class field_iterator
       : public std::iterator<std::forward_iterator_tag, FieldDef*> {
@@ -943,6 +955,8 @@ UPB_INLINE upb_oneofdef *upb_msgdef_ntoo_mutable(upb_msgdef *m,
 
 void upb_msgdef_setmapentry(upb_msgdef *m, bool map_entry);
 bool upb_msgdef_mapentry(const upb_msgdef *m);
+void upb_msgdef_setsyntax(upb_msgdef *m, upb_syntax_t syntax);
+upb_syntax_t upb_msgdef_syntax(const upb_msgdef *m);
 
 /* Well-known field tag numbers for map-entry messages. */
 #define UPB_MAPENTRY_KEY   1
@@ -1565,6 +1579,12 @@ inline void MessageDef::setmapentry(bool map_entry) {
 inline bool MessageDef::mapentry() const {
   return upb_msgdef_mapentry(this);
 }
+inline void MessageDef::setsyntax(upb_syntax_t syntax) {
+  upb_msgdef_setsyntax(this, syntax);
+}
+inline upb_syntax_t MessageDef::syntax() const {
+  return upb_msgdef_syntax(this);
+}
 inline MessageDef::field_iterator MessageDef::field_begin() {
   return field_iterator(this);
 }
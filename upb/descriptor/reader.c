@@ -58,7 +58,7 @@ struct upb_descreader {
   upb_descreader_frame stack[UPB_MAX_MESSAGE_NESTING];
   int stack_len;
 
-  bool primitives_have_presence;
+  upb_syntax_t syntax;
   int file_start;
 
   uint32_t number;
@@ -191,7 +191,7 @@ static bool file_startmsg(void *closure, const void *hd) {
   upb_descreader *r = closure;
   UPB_UNUSED(hd);
   upb_descreader_startcontainer(r);
-  r->primitives_have_presence = true;
+  r->syntax = UPB_SYNTAX_PROTO2;
   r->file_start = r->defs.len;
   return true;
 }
@@ -229,11 +229,12 @@ static size_t file_onsyntax(void *closure, const void *hd, const char *buf,
       upb_msgdef *m = upb_dyncast_msgdef_mutable(r->defs.defs[i]);
       if (m) {
         upb_msgdef_setprimitiveshavepresence(m, false);
+        upb_msgdef_setsyntax(m, UPB_SYNTAX_PROTO3);
       }
     }
 
     /* Set a flag for any future messages that will be created. */
-    r->primitives_have_presence = false;
+    r->syntax = UPB_SYNTAX_PROTO3;
   } else {
     /* Error: neither proto3 nor proto3.
      * TODO(haberman): there should be a status object we can report this to. */
@@ -541,7 +542,8 @@ static bool msg_startmsg(void *closure, const void *hd) {
   UPB_UNUSED(hd);
 
   m = upb_msgdef_new(&r->defs);
-  upb_msgdef_setprimitiveshavepresence(m, r->primitives_have_presence);
+  upb_msgdef_setprimitiveshavepresence(m, r->syntax == UPB_SYNTAX_PROTO2);
+  upb_msgdef_setsyntax(m, r->syntax);
   upb_deflist_push(&r->defs, upb_msgdef_upcast_mutable(m));
   upb_descreader_startcontainer(r);
   return true;
@@ -16,6 +16,8 @@ UPB_INLINE void upb_bufhandle_init(upb_bufhandle *h) {
   h->objtype_ = NULL;
   h->buf_ = NULL;
   h->objofs_ = 0;
+  h->pinfunc_ = NULL;
+  h->pinud_ = NULL;
 }
 UPB_INLINE void upb_bufhandle_uninit(upb_bufhandle *h) {
   UPB_UNUSED(h);
@@ -39,6 +41,24 @@ UPB_INLINE const void *upb_bufhandle_objtype(const upb_bufhandle *h) {
 UPB_INLINE const char *upb_bufhandle_buf(const upb_bufhandle *h) {
   return h->buf_;
 }
+UPB_INLINE void upb_bufhandle_setpinfunc(upb_bufhandle *h,
+                                         upb_bufhandle_pinfunc *func,
+                                         void *ud) {
+  h->pinfunc_ = func;
+  h->pinud_ = ud;
+}
+UPB_INLINE bool upb_bufhandle_pinnable(const upb_bufhandle *h) {
+  return h && h->pinfunc_;
+}
+
+/* upb_bufpin */
+UPB_INLINE void upb_bufpin_init(upb_bufpin *pin) {
+  pin->func_ = NULL;
+  pin->ud_ = NULL;
+}
+UPB_INLINE bool upb_bufpin_held(const upb_bufpin *pin) {
+  return pin->func_ != NULL;
+}
 
 
 #ifdef __cplusplus
@@ -567,6 +587,12 @@ bool ReturnTrue3(P1 p1, P2 p2, P3 p3) {
   return true;
 }
 
+template <class P1, class P2, class P3, class P4, void F(P1, P2, P3, P4)>
+bool ReturnTrue4(P1 p1, P2 p2, P3 p3, P4 p4) {
+  F(p1, p2, p3, p4);
+  return true;
+}
+
 /* Function wrapper that munges the return value from void to (void*)arg1  */
 template <class P1, class P2, void F(P1, P2)>
 void *ReturnClosure2(P1 p1, P2 p2) {
@@ -632,6 +658,12 @@ struct MaybeWrapReturn<Func3<void, P1, P2, P3, F, I>, bool> {
   typedef Func3<bool, P1, P2, P3, ReturnTrue3<P1, P2, P3, F>, I> Func;
 };
 
+template <class P1, class P2, class P3, class P4, void F(P1, P2, P3, P4),
+          class I>
+struct MaybeWrapReturn<Func4<void, P1, P2, P3, P4, F, I>, bool> {
+  typedef Func4<bool, P1, P2, P3, P4, ReturnTrue4<P1, P2, P3, P4, F>, I> Func;
+};
+
 /* If our function returns void but we want one returning void*, wrap it in a
  * function that returns the first argument. */
 template <class P1, class P2, void F(P1, P2), class I>
@@ -749,6 +781,12 @@ R CastHandlerData3(void *c, const void *hd, P3Wrapper p3) {
   return F(static_cast<P1>(c), static_cast<P2>(hd), p3);
 }
 
+template <class R, class P1, class P2, class P3, class P4,
+          R F(P1, P2, P3, P4)>
+R CastHandlerData4(void *c, const void *hd, P3 p3, P4 p4) {
+  return F(static_cast<P1>(c), static_cast<P2>(hd), p3, p4);
+}
+
 template <class R, class P1, class P2, class P3, class P4, class P5,
           R F(P1, P2, P3, P4, P5)>
 R CastHandlerData5(void *c, const void *hd, P3 p3, P4 p4, P5 p5) {
@@ -776,6 +814,15 @@ struct ConvertParams<Func2<R, P1, P2, F, I>,
                 IgnoreHandlerData3<R, P1, P3_2, P2, F>, I> Func;
 };
 
+/* For array handlers, which take four params. */
+template <class R, class P1, class P2, class P3, R F(P1, P2, P3), class I,
+          class R2, class P1_2, class P2_2, class P3_2, class P4_2>
+struct ConvertParams<Func3<R, P1, P2, P3, F, I>,
+                     R2 (*)(P1_2, P2_2, P3_2, P4_2)> {
+  typedef Func4<R, void *, const void *, P2, P3,
+                IgnoreHandlerData4<R, P1, P2, P3, F>, I> Func;
+};
+
 /* For StringBuffer only; this ignores both the handler data and the
  * BufferHandle. */
 template <class R, class P1, R F(P1, const char *, size_t), class I, class T>
@@ -807,6 +854,15 @@ struct ConvertParams<BoundFunc3<R, P1, P2, P3, F, I>,
                 CastHandlerData3<R, P1, P2, P3_2, P3, F>, I> Func;
 };
 
+/* For array handlers, which take four params. */
+template <class R, class P1, class P2, class P3, class P4, R F(P1, P2, P3, P4),
+          class I, class R2, class P1_2, class P2_2, class P3_2, class P4_2>
+struct ConvertParams<BoundFunc4<R, P1, P2, P3, P4, F, I>,
+                     R2 (*)(P1_2, P2_2, P3_2, P4_2)> {
+  typedef Func4<R, void *, const void *, P3, P4,
+                CastHandlerData4<R, P1, P2, P3, P4, F>, I> Func;
+};
+
 /* For StringBuffer only; this ignores the BufferHandle. */
 template <class R, class P1, class P2, R F(P1, P2, const char *, size_t),
           class I, class T>
@@ -880,6 +936,25 @@ TYPE_METHODS(Int32,  int32_t)
 TYPE_METHODS(Bool,   bool)
 #undef TYPE_METHODS
 
+#define TYPE_METHODS(utype, ltype) \
+    inline bool Handlers::Set##utype##ArrayHandler( \
+        const FieldDef *f, const utype##ArrayHandler &handler) { \
+      assert(!handler.registered_); \
+      handler.AddCleanup(this); \
+      handler.registered_ = true; \
+      return upb_handlers_set##ltype##array(this, f, handler.handler_, \
+                                            &handler.attr_); \
+    } \
+
+TYPE_METHODS(Double, double)
+TYPE_METHODS(Float,  float)
+TYPE_METHODS(UInt64, uint64)
+TYPE_METHODS(UInt32, uint32)
+TYPE_METHODS(Int64,  int64)
+TYPE_METHODS(Int32,  int32)
+TYPE_METHODS(Bool,   bool)
+#undef TYPE_METHODS
+
 template <class F> struct ReturnOf;
 
 template <class R, class P1, class P2>
@@ -986,6 +1061,15 @@ inline size_t BufferHandle::object_offset() const {
 inline void BufferHandle::SetBuffer(const char* buf, size_t ofs) {
   upb_bufhandle_setbuf(this, buf, ofs);
 }
+inline void BufferHandle::SetPinFunc(upb_bufhandle_pinfunc* func, void* ud) {
+  upb_bufhandle_setpinfunc(this, func, ud);
+}
+inline bool BufferHandle::pinnable() const {
+  return upb_bufhandle_pinnable(this);
+}
+inline bool BufferHandle::Pin(BufferPin* pin) const {
+  return upb_bufhandle_pin(this, pin);
+}
 template <class T>
 void BufferHandle::SetAttachedObject(const T* obj) {
   upb_bufhandle_setobj(this, obj, UniquePtrForType<T>());
@@ -997,6 +1081,11 @@ const T* BufferHandle::GetAttachedObject() const {
                                : NULL;
 }
 
+inline BufferPin::BufferPin() { upb_bufpin_init(this); }
+inline BufferPin::~BufferPin() { upb_bufpin_release(this); }
+inline bool BufferPin::held() const { return upb_bufpin_held(this); }
+inline void BufferPin::Release() { upb_bufpin_release(this); }
+
 inline reffed_ptr<Handlers> Handlers::New(const MessageDef *m) {
   upb_handlers *h = upb_handlers_new(m, &h);
   return reffed_ptr<Handlers>(h, &h);
@@ -1043,6 +1132,13 @@ inline bool Handlers::SetEndMessageHandler(
   handler.AddCleanup(this);
   return upb_handlers_setendmsg(this, handler.handler_, &handler.attr_);
 }
+inline bool Handlers::SetUnknownHandler(
+    const Handlers::StringHandler &handler) {
+  assert(!handler.registered_);
+  handler.registered_ = true;
+  handler.AddCleanup(this);
+  return upb_handlers_setunknown(this, handler.handler_, &handler.attr_);
+}
 inline bool Handlers::SetStartStringHandler(const FieldDef *f,
                                             const StartStringHandler &handler) {
   assert(!handler.registered_);
@@ -360,6 +360,29 @@ SETTER(endseq,      upb_endfield_handlerfunc*,    UPB_HANDLER_ENDSEQ)
 
 #undef SETTER
 
+/* Array handlers all share UPB_HANDLER_ARRAY, so the setters also check that
+ * the field's element type matches the handler's. */
+#define ARRAYSETTER(name, handlerctype, valuetype) \
+  bool upb_handlers_set ## name ## array(upb_handlers *h, \
+                                         const upb_fielddef *f, \
+                                         handlerctype func, \
+                                         upb_handlerattr *attr) { \
+    int32_t sel = trygetsel(h, f, UPB_HANDLER_ARRAY); \
+    if (sel >= 0 && upb_handlers_getprimitivehandlertype(f) != valuetype) \
+      sel = -1; \
+    return doset(h, sel, f, UPB_HANDLER_ARRAY, (upb_func*)func, attr); \
+  }
+
+ARRAYSETTER(int32,  upb_int32array_handlerfunc*,  UPB_HANDLER_INT32)
+ARRAYSETTER(int64,  upb_int64array_handlerfunc*,  UPB_HANDLER_INT64)
+ARRAYSETTER(uint32, upb_uint32array_handlerfunc*, UPB_HANDLER_UINT32)
+ARRAYSETTER(uint64, upb_uint64array_handlerfunc*, UPB_HANDLER_UINT64)
+ARRAYSETTER(float,  upb_floatarray_handlerfunc*,  UPB_HANDLER_FLOAT)
+ARRAYSETTER(double, upb_doublearray_handlerfunc*, UPB_HANDLER_DOUBLE)
+ARRAYSETTER(bool,   upb_boolarray_handlerfunc*,   UPB_HANDLER_BOOL)
+
+#undef ARRAYSETTER
+
 bool upb_handlers_setstartmsg(upb_handlers *h, upb_startmsg_handlerfunc *func,
                               upb_handlerattr *attr) {
   return doset(h, UPB_STARTMSG_SELECTOR, NULL, UPB_HANDLER_INT32,
@@ -373,6 +396,12 @@ bool upb_handlers_setendmsg(upb_handlers *h, upb_endmsg_handlerfunc *func,
                (upb_func *)func, attr);
 }
 
+bool upb_handlers_setunknown(upb_handlers *h, upb_string_handlerfunc *func,
+                             upb_handlerattr *attr) {
+  return doset(h, UPB_UNKNOWN_SELECTOR, NULL, UPB_HANDLER_INT32,
+               (upb_func *)func, attr);
+}
+
 bool upb_handlers_setsubhandlers(upb_handlers *h, const upb_fielddef *f,
                                  const upb_handlers *sub) {
   assert(sub);
@@ -566,6 +595,11 @@ bool upb_handlers_getselector(const upb_fielddef *f, upb_handlertype_t type,
       if (!upb_fielddef_isseq(f)) return false;
       *s = f->selector_base - 1;
       break;
+    case UPB_HANDLER_ARRAY:
+      if (!upb_fielddef_isseq(f) || !upb_fielddef_isprimitive(f))
+        return false;
+      *s = f->selector_base + 1;
+      break;
     case UPB_HANDLER_STARTSUBMSG:
       if (!upb_fielddef_issubmsg(f)) return false;
       /* Selectors for STARTSUBMSG are at the beginning of the table so that the
@@ -590,6 +624,9 @@ uint32_t upb_handlers_selectorbaseoffset(const upb_fielddef *f) {
 uint32_t upb_handlers_selectorcount(const upb_fielddef *f) {
   uint32_t ret = 1;
   if (upb_fielddef_isseq(f)) ret += 2;    /* STARTSEQ/ENDSEQ */
+  if (upb_fielddef_isseq(f) && upb_fielddef_isprimitive(f)) {
+    ret += 1;                             /* ARRAY */
+  }
   if (upb_fielddef_isstring(f)) ret += 2; /* [STRING]/STARTSTR/ENDSTR */
   if (upb_fielddef_issubmsg(f)) {
     /* ENDSUBMSG (STARTSUBMSG is at table beginning) */
@@ -653,6 +690,23 @@ size_t upb_bufhandle_objofs(const upb_bufhandle *h) {
   return h->objofs_;
 }
 
+bool upb_bufhandle_pin(const upb_bufhandle *h, upb_bufpin *pin) {
+  assert(!upb_bufpin_held(pin));
+  if (!upb_bufhandle_pinnable(h)) return false;
+  h->pinfunc_(h->pinud_, true);
+  pin->func_ = h->pinfunc_;
+  pin->ud_ = h->pinud_;
+  return true;
+}
+
+/* upb_bufpin *****************************************************************/
+
+void upb_bufpin_release(upb_bufpin *pin) {
+  if (!upb_bufpin_held(pin)) return;
+  pin->func_(pin->ud_, false);
+  upb_bufpin_init(pin);
+}
+
 /* upb_byteshandler ***********************************************************/
 
 void upb_byteshandler_init(upb_byteshandler* h) {
@@ -684,3 +738,10 @@ bool upb_byteshandler_setendstr(upb_byteshandler *h,
   h->table[UPB_ENDSTR_SELECTOR].attr.handler_data_ = d;
   return true;
 }
+
+bool upb_byteshandler_setiovec(upb_byteshandler *h,
+                               upb_iovec_handlerfunc *func, void *d) {
+  h->table[UPB_IOVEC_SELECTOR].func = (upb_func*)func;
+  h->table[UPB_IOVEC_SELECTOR].attr.handler_data_ = d;
+  return true;
+}
@@ -25,6 +25,7 @@
 #ifdef __cplusplus
 namespace upb {
 class BufferHandle;
+class BufferPin;
 class BytesHandler;
 class HandlerAttributes;
 class Handlers;
@@ -34,6 +35,7 @@ template <class T> struct CanonicalType;
 #endif
 
 UPB_DECLARE_TYPE(upb::BufferHandle, upb_bufhandle)
+UPB_DECLARE_TYPE(upb::BufferPin, upb_bufpin)
 UPB_DECLARE_TYPE(upb::BytesHandler, upb_byteshandler)
 UPB_DECLARE_TYPE(upb::HandlerAttributes, upb_handlerattr)
 UPB_DECLARE_DERIVED_TYPE(upb::Handlers, upb::RefCounted,
@@ -64,10 +66,11 @@ typedef enum {
   UPB_HANDLER_STARTSUBMSG,
   UPB_HANDLER_ENDSUBMSG,
   UPB_HANDLER_STARTSEQ,
-  UPB_HANDLER_ENDSEQ
+  UPB_HANDLER_ENDSEQ,
+  UPB_HANDLER_ARRAY
 } upb_handlertype_t;
 
-#define UPB_HANDLER_MAX (UPB_HANDLER_ENDSEQ+1)
+#define UPB_HANDLER_MAX (UPB_HANDLER_ARRAY+1)
 
 #define UPB_BREAK NULL
 
@@ -89,6 +92,12 @@ UPB_INLINE const void *upb_handlerattr_handlerdata(const upb_handlerattr *attr);
 UPB_INLINE const void *upb_handlers_gethandlerdata(const upb_handlers *h,
                                                    upb_selector_t s);
 
+/* A function that pins (pin == true) or unpins (pin == false) the storage
+ * behind a buffer, for example by taking or dropping a reference on it.  "ud"
+ * is the value that was passed along with the function to
+ * upb_bufhandle_setpinfunc(). */
+typedef void upb_bufhandle_pinfunc(void *ud, bool pin);
+
 UPB_INLINE void upb_bufhandle_init(upb_bufhandle *h);
 UPB_INLINE void upb_bufhandle_setobj(upb_bufhandle *h, const void *obj,
                                      const void *type);
@@ -97,6 +106,14 @@ UPB_INLINE void upb_bufhandle_setbuf(upb_bufhandle *h, const char *buf,
 UPB_INLINE const void *upb_bufhandle_obj(const upb_bufhandle *h);
 UPB_INLINE const void *upb_bufhandle_objtype(const upb_bufhandle *h);
 UPB_INLINE const char *upb_bufhandle_buf(const upb_bufhandle *h);
+UPB_INLINE void upb_bufhandle_setpinfunc(upb_bufhandle *h,
+                                         upb_bufhandle_pinfunc *func, void *ud);
+UPB_INLINE bool upb_bufhandle_pinnable(const upb_bufhandle *h);
+bool upb_bufhandle_pin(const upb_bufhandle *h, upb_bufpin *pin);
+
+UPB_INLINE void upb_bufpin_init(upb_bufpin *pin);
+UPB_INLINE bool upb_bufpin_held(const upb_bufpin *pin);
+void upb_bufpin_release(upb_bufpin *pin);
 
 UPB_END_EXTERN_C
 
@@ -104,12 +121,14 @@ UPB_END_EXTERN_C
 /* Static selectors for upb::Handlers. */
 #define UPB_STARTMSG_SELECTOR 0
 #define UPB_ENDMSG_SELECTOR 1
-#define UPB_STATIC_SELECTOR_COUNT 2
+#define UPB_UNKNOWN_SELECTOR 2
+#define UPB_STATIC_SELECTOR_COUNT 3
 
 /* Static selectors for upb::BytesHandler. */
 #define UPB_STARTSTR_SELECTOR 0
 #define UPB_STRING_SELECTOR 1
 #define UPB_ENDSTR_SELECTOR 2
+#define UPB_IOVEC_SELECTOR 3
 
 typedef void upb_handlerfree(void *d);
 
@@ -180,8 +199,13 @@ typedef struct {
 #ifdef __cplusplus
 
 /* Extra information about a buffer that is passed to a StringBuf handler.
- * TODO(haberman): allow the handle to be pinned so that it will outlive
- * the handler invocation. */
+ *
+ * Normally a handler may only look at the buffer for the duration of the
+ * call.  If whoever owns the buffer gives the handle a pin function, a handler
+ * can Pin() it instead and keep pointers into the buffer (for example, to
+ * forward a large bytes field without copying it) until it releases the pin.
+ * Parsers only pass a handle along with data that points into the caller's
+ * buffer; data they had to copy or transform comes with a NULL handle. */
 class upb::BufferHandle {
  public:
   BufferHandle();
@@ -209,6 +233,21 @@ class upb::BufferHandle {
   template <class T>
   const T* GetAttachedObject() const;
 
+  /* Makes the buffer pinnable.  "func" is called with pin=true from Pin() and
+   * pin=false when that pin is released, which may happen after the handle
+   * itself has gone away.  "func" must be thread-safe if pins may be released
+   * from other threads. */
+  void SetPinFunc(upb_bufhandle_pinfunc* func, void* ud);
+
+  /* Returns true if the buffer can be pinned. */
+  bool pinnable() const;
+
+  /* Pins the buffer so that it stays valid after the handler returns, until
+   * "pin" is released.  Returns false (leaving "pin" unchanged) if the buffer
+   * is not pinnable, in which case the handler must copy anything it wants to
+   * keep.  "pin" must not already hold a pin. */
+  bool Pin(BufferPin* pin) const;
+
  private:
   friend UPB_INLINE void ::upb_bufhandle_init(upb_bufhandle *h);
   friend UPB_INLINE void ::upb_bufhandle_setobj(upb_bufhandle *h,
@@ -220,6 +259,10 @@ class upb::BufferHandle {
   friend UPB_INLINE const void* ::upb_bufhandle_objtype(
       const upb_bufhandle *h);
   friend UPB_INLINE const char* ::upb_bufhandle_buf(const upb_bufhandle *h);
+  friend UPB_INLINE void ::upb_bufhandle_setpinfunc(
+      upb_bufhandle *h, upb_bufhandle_pinfunc *func, void *ud);
+  friend UPB_INLINE bool ::upb_bufhandle_pinnable(const upb_bufhandle *h);
+  friend bool ::upb_bufhandle_pin(const upb_bufhandle *h, upb_bufpin *pin);
 #else
 struct upb_bufhandle {
 #endif
@@ -227,6 +270,37 @@ struct upb_bufhandle {
   const void *obj_;
   const void *objtype_;
   size_t objofs_;
+  upb_bufhandle_pinfunc *pinfunc_;
+  void *pinud_;
+};
+
+#ifdef __cplusplus
+
+/* A pin on a buffer, obtained from BufferHandle::Pin().  The buffer stays
+ * valid until the pin is released, either explicitly or when the BufferPin is
+ * destroyed. */
+class upb::BufferPin {
+ public:
+  BufferPin();
+  ~BufferPin();
+
+  /* Returns true if this currently holds a pin. */
+  bool held() const;
+
+  /* Releases the pin, if any. */
+  void Release();
+
+ private:
+  UPB_DISALLOW_COPY_AND_ASSIGN(BufferPin)
+  friend bool ::upb_bufhandle_pin(const upb_bufhandle *h, upb_bufpin *pin);
+  friend UPB_INLINE void ::upb_bufpin_init(upb_bufpin *pin);
+  friend UPB_INLINE bool ::upb_bufpin_held(const upb_bufpin *pin);
+  friend void ::upb_bufpin_release(upb_bufpin *pin);
+#else
+struct upb_bufpin {
+#endif
+  upb_bufhandle_pinfunc *func_;
+  void *ud_;
 };
 
 #ifdef __cplusplus
@@ -267,6 +341,18 @@ class upb::Handlers {
   typedef ValueHandler<double>::H      DoubleHandler;
   typedef ValueHandler<bool>::H        BoolHandler;
 
+  template <class T> struct ArrayHandler {
+    typedef Handler<bool(*)(void *, const void *, const T *, size_t)> H;
+  };
+
+  typedef ArrayHandler<int32_t>::H     Int32ArrayHandler;
+  typedef ArrayHandler<int64_t>::H     Int64ArrayHandler;
+  typedef ArrayHandler<uint32_t>::H    UInt32ArrayHandler;
+  typedef ArrayHandler<uint64_t>::H    UInt64ArrayHandler;
+  typedef ArrayHandler<float>::H       FloatArrayHandler;
+  typedef ArrayHandler<double>::H      DoubleArrayHandler;
+  typedef ArrayHandler<bool>::H        BoolArrayHandler;
+
   /* Any function pointer can be converted to this and converted back to its
    * correct type. */
   typedef void GenericFunction();
@@ -335,6 +421,27 @@ class upb::Handlers {
    */
   bool SetEndMessageHandler(const EndMessageHandler& handler);
 
+  /* Sets the unknown field handler for the message, which is a string handler
+   * (see SetStringHandler() below) that receives the message's unknown fields
+   * in their wire format:
+   *
+   *   size_t unknown(MyType* closure, const char *buf, size_t len,
+   *                  const BufferHandle* handle) {
+   *     // Called with the next "len" bytes of unknown fields.  Returns "len"
+   *     // to continue; any other value stops parsing with an error.
+   *     return len;
+   *   }
+   *
+   * Concatenating every "buf" passed for one message gives its unknown fields,
+   * tag and all, in the order they appeared, so they can be written back out
+   * verbatim.  A single field may be split across several calls.  Tags and
+   * lengths may be re-encoded, but field payloads are passed through as-is
+   * and come with the input's BufferHandle when they point into the caller's
+   * buffer.
+   *
+   * Without this handler, unknown fields are skipped. */
+  bool SetUnknownHandler(const StringHandler& handler);
+
   /* Sets the value handler for the given field, which is defined as follows
    * (this is for an int32 field; other field types will pass their native
    * C/C++ type for "val"):
@@ -372,6 +479,35 @@ class upb::Handlers {
       const FieldDef *f,
       const typename ValueHandler<typename CanonicalType<T>::Type>::H& handler);
 
+  /* Sets the array handler for the given repeated field, which is defined as
+   * follows (this is for an int32 field):
+   *
+   *   bool OnValues(MyClosure* c, const MyHandlerData* d,
+   *                 const int32_t* vals, size_t n) {
+   *     // Called with a run of "n" consecutive values of the sequence.
+   *     // Returns true if processing should continue.
+   *     return true;
+   *   }
+   *
+   * An array handler is an optional companion to the value handler: sources
+   * that can produce several values at once (like the protobuf decoder for
+   * packed fields) may deliver them through a single call to it instead of
+   * one call per value.  A source may still deliver any value through the
+   * value handler, so a field that sets an array handler should generally
+   * set a value handler too.  Both are called with the sequence's closure.
+   *
+   * "vals" is only valid for the duration of the call.  For packed fixed-width
+   * fields the decoder may point it directly into the input buffer.
+   *
+   * The value type must match f->type() exactly, as for value handlers. */
+  bool SetInt32ArrayHandler (const FieldDef* f,  const Int32ArrayHandler& h);
+  bool SetInt64ArrayHandler (const FieldDef* f,  const Int64ArrayHandler& h);
+  bool SetUInt32ArrayHandler(const FieldDef* f, const UInt32ArrayHandler& h);
+  bool SetUInt64ArrayHandler(const FieldDef* f, const UInt64ArrayHandler& h);
+  bool SetFloatArrayHandler (const FieldDef* f,  const FloatArrayHandler& h);
+  bool SetDoubleArrayHandler(const FieldDef* f, const DoubleArrayHandler& h);
+  bool SetBoolArrayHandler  (const FieldDef* f,   const BoolArrayHandler& h);
+
   /* Sets handlers for a string field, which are defined as follows:
    *
    *   MySubClosure* startstr(MyClosure* c, const MyHandlerData* d,
@@ -648,6 +784,32 @@ typedef void *upb_startstr_handlerfunc(void *c, const void *hd,
                                        size_t size_hint);
 typedef size_t upb_string_handlerfunc(void *c, const void *hd, const char *buf,
                                       size_t n, const upb_bufhandle* handle);
+typedef bool upb_int32array_handlerfunc(void *c, const void *hd,
+                                        const int32_t *vals, size_t n);
+typedef bool upb_int64array_handlerfunc(void *c, const void *hd,
+                                        const int64_t *vals, size_t n);
+typedef bool upb_uint32array_handlerfunc(void *c, const void *hd,
+                                         const uint32_t *vals, size_t n);
+typedef bool upb_uint64array_handlerfunc(void *c, const void *hd,
+                                         const uint64_t *vals, size_t n);
+typedef bool upb_floatarray_handlerfunc(void *c, const void *hd,
+                                        const float *vals, size_t n);
+typedef bool upb_doublearray_handlerfunc(void *c, const void *hd,
+                                         const double *vals, size_t n);
+typedef bool upb_boolarray_handlerfunc(void *c, const void *hd,
+                                       const bool *vals, size_t n);
+
+/* One piece of a gathered write: like POSIX "struct iovec", but const. */
+typedef struct {
+  const char *base;
+  size_t len;
+} upb_iovec;
+
+/* Receives "n" pieces of data at once, to be written in order.  The pieces
+ * are only valid for the duration of the call.  Returns false unless all of
+ * the data was accepted. */
+typedef bool upb_iovec_handlerfunc(void *c, const void *hd,
+                                   const upb_iovec *iov, size_t n);
 
 /* upb_bufhandle */
 size_t upb_bufhandle_objofs(const upb_bufhandle *h);
@@ -691,6 +853,8 @@ bool upb_handlers_setstartmsg(upb_handlers *h, upb_startmsg_handlerfunc *func,
                               upb_handlerattr *attr);
 bool upb_handlers_setendmsg(upb_handlers *h, upb_endmsg_handlerfunc *func,
                             upb_handlerattr *attr);
+bool upb_handlers_setunknown(upb_handlers *h, upb_string_handlerfunc *func,
+                             upb_handlerattr *attr);
 bool upb_handlers_setint32(upb_handlers *h, const upb_fielddef *f,
                            upb_int32_handlerfunc *func, upb_handlerattr *attr);
 bool upb_handlers_setint64(upb_handlers *h, const upb_fielddef *f,
@@ -730,6 +894,27 @@ bool upb_handlers_setendsubmsg(upb_handlers *h, const upb_fielddef *f,
 bool upb_handlers_setendseq(upb_handlers *h, const upb_fielddef *f,
                             upb_endfield_handlerfunc *func,
                             upb_handlerattr *attr);
+bool upb_handlers_setint32array(upb_handlers *h, const upb_fielddef *f,
+                                upb_int32array_handlerfunc *func,
+                                upb_handlerattr *attr);
+bool upb_handlers_setint64array(upb_handlers *h, const upb_fielddef *f,
+                                upb_int64array_handlerfunc *func,
+                                upb_handlerattr *attr);
+bool upb_handlers_setuint32array(upb_handlers *h, const upb_fielddef *f,
+                                 upb_uint32array_handlerfunc *func,
+                                 upb_handlerattr *attr);
+bool upb_handlers_setuint64array(upb_handlers *h, const upb_fielddef *f,
+                                 upb_uint64array_handlerfunc *func,
+                                 upb_handlerattr *attr);
+bool upb_handlers_setfloatarray(upb_handlers *h, const upb_fielddef *f,
+                                upb_floatarray_handlerfunc *func,
+                                upb_handlerattr *attr);
+bool upb_handlers_setdoublearray(upb_handlers *h, const upb_fielddef *f,
+                                 upb_doublearray_handlerfunc *func,
+                                 upb_handlerattr *attr);
+bool upb_handlers_setboolarray(upb_handlers *h, const upb_fielddef *f,
+                               upb_boolarray_handlerfunc *func,
+                               upb_handlerattr *attr);
 
 bool upb_handlers_setsubhandlers(upb_handlers *h, const upb_fielddef *f,
                                  const upb_handlers *sub);
@@ -765,7 +950,7 @@ class upb::BytesHandler {
 #else
 struct upb_byteshandler {
 #endif
-  upb_handlers_tabent table[3];
+  upb_handlers_tabent table[4];
 };
 
 void upb_byteshandler_init(upb_byteshandler *h);
@@ -781,6 +966,12 @@ bool upb_byteshandler_setstring(upb_byteshandler *h,
 bool upb_byteshandler_setendstr(upb_byteshandler *h,
                                 upb_endfield_handlerfunc *func, void *d);
 
+/* Optional: lets a producer hand over several pieces of data in one call, for
+ * sinks that can write them without joining them first (eg. with writev()).
+ * Without it such batches go to the string handler one piece at a time. */
+bool upb_byteshandler_setiovec(upb_byteshandler *h,
+                               upb_iovec_handlerfunc *func, void *d);
+
 /* "Static" methods */
 bool upb_handlers_freeze(upb_handlers *const *handlers, int n, upb_status *s);
 upb_handlertype_t upb_handlers_getprimitivehandlertype(const upb_fielddef *f);
@@ -790,6 +981,12 @@ UPB_INLINE upb_selector_t upb_handlers_getendselector(upb_selector_t start) {
   return start + 1;
 }
 
+/* For a repeated primitive field, the array handler's selector follows the
+ * value handler's. */
+UPB_INLINE upb_selector_t upb_handlers_getarrayselector(upb_selector_t val) {
+  return val + 1;
+}
+
 /* Internal-only. */
 uint32_t upb_handlers_selectorbaseoffset(const upb_fielddef *f);
 uint32_t upb_handlers_selectorcount(const upb_fielddef *f);
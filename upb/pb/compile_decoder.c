@@ -13,25 +13,34 @@
 */
 
 #include <stdarg.h>
+#include <stdio.h>
 #include "upb/pb/decoder.int.h"
 #include "upb/pb/varint.int.h"
 
-#ifdef UPB_DUMP_BYTECODE
-#include <stdio.h>
-#endif
-
 #define MAXLABEL 5
 #define EMPTYLABEL -1
 
+static void unmapimage(void *image, size_t size);
+
 /* mgroup *********************************************************************/
 
 static void freegroup(upb_refcounted *r) {
   mgroup *g = (mgroup*)r;
+  upb_inttable_iter i;
+  upb_inttable_begin(&i, &g->linked);
+  for(; !upb_inttable_done(&i); upb_inttable_next(&i)) {
+    mgroup_unref((const mgroup*)upb_inttable_iter_key(&i), g);
+  }
+  upb_inttable_uninit(&g->linked);
   upb_inttable_uninit(&g->methods);
 #ifdef UPB_USE_JIT_X64
   upb_pbdecoder_freejit(g);
 #endif
-  free(g->bytecode);
+  if (g->image) {
+    unmapimage(g->image, g->image_size);
+  } else {
+    free(g->bytecode);
+  }
   free(g);
 }
 
@@ -51,8 +60,14 @@ mgroup *newgroup(const void *owner) {
   static const struct upb_refcounted_vtbl vtbl = {visitgroup, freegroup};
   upb_refcounted_init(mgroup_upcast_mutable(g), &vtbl, owner);
   upb_inttable_init(&g->methods, UPB_CTYPE_PTR);
+  upb_inttable_init(&g->linked, UPB_CTYPE_BOOL);
   g->bytecode = NULL;
   g->bytecode_end = NULL;
+  g->image = NULL;
+  g->image_size = 0;
+#ifdef UPB_USE_JIT_X64
+  g->jit_code = NULL;
+#endif
   return g;
 }
 
@@ -67,6 +82,8 @@ static void freemethod(upb_refcounted *r) {
   }
 
   upb_inttable_uninit(&method->dispatch);
+  free(method->interp_dispatch.entries);
+  free(method->interp_dispatch.seeds);
   free(method);
 }
 
@@ -92,7 +109,11 @@ static upb_pbdecodermethod *newmethod(const upb_handlers *dest_handlers,
   ret->group = mgroup_upcast_mutable(group);
   ret->dest_handlers_ = dest_handlers;
   ret->is_native_ = false;  /* If we JIT, it will update this later. */
+  ret->count_uses_ = false;
+  ret->jit_refused_ = 0;
+  ret->uses_ = 0;
   upb_inttable_init(&ret->dispatch, UPB_CTYPE_UINT64);
+  memset(&ret->interp_dispatch, 0, sizeof(ret->interp_dispatch));
 
   if (ret->dest_handlers_) {
     upb_handlers_ref(ret->dest_handlers_, ret);
@@ -114,6 +135,33 @@ bool upb_pbdecodermethod_isnative(const upb_pbdecodermethod *m) {
   return m->is_native_;
 }
 
+const upb_pbdecodermethod *upb_pbdecodermethod_submethod(
+    const upb_pbdecodermethod *m, const upb_fielddef *f) {
+  const mgroup *g = (const mgroup*)m->group;
+  const upb_handlers *sub;
+  upb_inttable_iter i;
+  upb_value v;
+
+  if (!upb_fielddef_issubmsg(f)) return NULL;
+  sub = upb_handlers_getsubhandlers(m->dest_handlers_, f);
+  if (!sub) return NULL;
+
+  if (upb_inttable_lookupptr(&g->methods, sub, &v)) {
+    return upb_value_getptr(v);
+  }
+
+  /* A submessage whose method was linked lives in one of our linked groups. */
+  upb_inttable_begin(&i, &g->linked);
+  for(; !upb_inttable_done(&i); upb_inttable_next(&i)) {
+    const mgroup *linked = (const mgroup*)upb_inttable_iter_key(&i);
+    if (upb_inttable_lookupptr(&linked->methods, sub, &v)) {
+      return upb_value_getptr(v);
+    }
+  }
+
+  return NULL;
+}
+
 const upb_pbdecodermethod *upb_pbdecodermethod_new(
     const upb_pbdecodermethodopts *opts, const void *owner) {
   const upb_pbdecodermethod *ret;
@@ -121,12 +169,104 @@ const upb_pbdecodermethod *upb_pbdecodermethod_new(
 
   upb_pbcodecache_init(&cache);
   ret = upb_pbcodecache_getdecodermethod(&cache, opts);
-  upb_pbdecodermethod_ref(ret, owner);
+  if (ret) upb_pbdecodermethod_ref(ret, owner);
   upb_pbcodecache_uninit(&cache);
   return ret;
 }
 
 
+/* method keys ****************************************************************/
+
+/* Key under which a method is cached: the frozen destination handlers plus
+ * every method option that affects the generated code.  allow_jit is fixed for
+ * the whole cache, so it does not need to be part of the key.
+ *
+ * The fields of the field mask, if any, directly follow this struct in the
+ * key.  They are sorted and without duplicates, so that equal masks give equal
+ * keys.
+ *
+ * We use the raw bytes of the key as a strtable key, so it must always be
+ * zeroed before being filled in (to clear any padding). */
+typedef struct {
+  const upb_handlers *handlers;
+  bool lazy;
+  bool early_exit;
+  bool verify_utf8;
+  size_t fieldmask_len;
+} methodkey;
+
+/* Keys with masks up to this size are built on the stack. */
+#define KEY_INLINE_FIELDS 8
+
+typedef struct {
+  methodkey key;
+  const upb_fielddef *fields[KEY_INLINE_FIELDS];
+} keybuf;
+
+static const upb_fielddef **keyfields(methodkey *key) {
+  return (const upb_fielddef**)(key + 1);
+}
+
+static size_t keysize(const methodkey *key) {
+  return sizeof(*key) + key->fieldmask_len * sizeof(const upb_fielddef*);
+}
+
+static int cmpfield(const void *a, const void *b) {
+  uintptr_t x = (uintptr_t)*(const upb_fielddef *const *)a;
+  uintptr_t y = (uintptr_t)*(const upb_fielddef *const *)b;
+  return x < y ? -1 : (x > y);
+}
+
+/* Builds the key for "h" under "opts" in "buf", or on the heap if the mask is
+ * too big for "buf".  Returns NULL if allocation fails.  Release the key with
+ * freekey(). */
+static methodkey *initkey(keybuf *buf, const upb_handlers *h,
+                          const upb_pbdecodermethodopts *opts) {
+  methodkey *key = &buf->key;
+  const upb_fielddef **fields;
+  size_t n = opts->fieldmask_len;
+  size_t i, j;
+
+  /* keyfields() expects the inline fields to directly follow the key. */
+  assert(offsetof(keybuf, fields) == sizeof(methodkey));
+
+  if (n > KEY_INLINE_FIELDS) {
+    key = malloc(sizeof(*key) + n * sizeof(const upb_fielddef*));
+    if (!key) return NULL;
+  }
+
+  memset(key, 0, sizeof(*key));
+  key->handlers = h;
+  key->lazy = opts->lazy;
+  key->early_exit = opts->early_exit;
+  key->verify_utf8 = opts->verify_utf8;
+
+  fields = keyfields(key);
+  if (n > 0) {
+    memcpy(fields, opts->fieldmask, n * sizeof(const upb_fielddef*));
+    qsort(fields, n, sizeof(const upb_fielddef*), cmpfield);
+    for (i = 1, j = 1; i < n; i++) {
+      if (fields[i] != fields[j - 1]) fields[j++] = fields[i];
+    }
+    n = j;
+  }
+  key->fieldmask_len = n;
+  return key;
+}
+
+static void freekey(keybuf *buf, methodkey *key) {
+  if (key != &buf->key) free(key);
+}
+
+static const upb_pbdecodermethod *lookupmethod(const upb_strtable *t,
+                                               const methodkey *key) {
+  upb_value v;
+  return upb_strtable_lookup2(t, (const char*)key, keysize(key), &v)
+             ? upb_value_getconstptr(v)
+             : NULL;
+}
+
+
 /* bytecode compiler **********************************************************/
 
 /* Data used only at compilation time. */
@@ -137,16 +277,60 @@ typedef struct {
   int fwd_labels[MAXLABEL];
   int back_labels[MAXLABEL];
 
+  /* The options we are compiling for. */
+  const upb_pbdecodermethodopts *opts;
+
   /* For fields marked "lazy", parse them lazily or eagerly? */
   bool lazy;
+
+  /* Emit OP_SEEN so that messages stop once their needed fields are seen? */
+  bool early_exit;
+
+  /* Emit OP_STRING_UTF8 for the string fields of proto3 messages? */
+  bool verify_utf8;
+
+  /* If the options have a field mask: the set of its fields, and the set of
+   * messages that have fields in it.  Both are keyed by pointer. */
+  bool masked;
+  upb_inttable maskfields;
+  upb_inttable maskmsgs;
+
+  /* Previously compiled methods (in other groups) that we may call instead of
+   * compiling them again, keyed by method key.  NULL if linking is disabled. */
+  const upb_strtable *linkable;
+
+  /* Maps upb_handlers -> upb_pbdecodermethod for every method from another
+   * group that this group calls. */
+  upb_inttable linked;
 } compiler;
 
-static compiler *newcompiler(mgroup *group, bool lazy) {
+static compiler *newcompiler(mgroup *group,
+                             const upb_pbdecodermethodopts *opts,
+                             const upb_strtable *linkable) {
   compiler *ret = malloc(sizeof(*ret));
+  size_t n;
   int i;
 
   ret->group = group;
-  ret->lazy = lazy;
+  ret->opts = opts;
+  ret->lazy = opts->lazy;
+  ret->early_exit = opts->early_exit;
+  ret->verify_utf8 = opts->verify_utf8;
+  ret->linkable = linkable;
+  ret->masked = opts->fieldmask_len > 0;
+  upb_inttable_init(&ret->linked, UPB_CTYPE_CONSTPTR);
+  upb_inttable_init(&ret->maskfields, UPB_CTYPE_BOOL);
+  upb_inttable_init(&ret->maskmsgs, UPB_CTYPE_BOOL);
+  for (n = 0; n < opts->fieldmask_len; n++) {
+    const upb_fielddef *f = opts->fieldmask[n];
+    const upb_msgdef *md = upb_fielddef_containingtype(f);
+    if (!upb_inttable_lookupptr(&ret->maskfields, f, NULL)) {
+      upb_inttable_insertptr(&ret->maskfields, f, upb_value_bool(true));
+    }
+    if (!upb_inttable_lookupptr(&ret->maskmsgs, md, NULL)) {
+      upb_inttable_insertptr(&ret->maskmsgs, md, upb_value_bool(true));
+    }
+  }
   for (i = 0; i < MAXLABEL; i++) {
     ret->fwd_labels[i] = EMPTYLABEL;
     ret->back_labels[i] = EMPTYLABEL;
@@ -155,6 +339,9 @@ static compiler *newcompiler(mgroup *group, bool lazy) {
 }
 
 static void freecompiler(compiler *c) {
+  upb_inttable_uninit(&c->linked);
+  upb_inttable_uninit(&c->maskfields);
+  upb_inttable_uninit(&c->maskmsgs);
   free(c);
 }
 
@@ -164,8 +351,10 @@ const size_t ptr_words = sizeof(void*) / sizeof(uint32_t);
 static int instruction_len(uint32_t instr) {
   switch (getop(instr)) {
     case OP_SETDISPATCH: return 1 + ptr_words;
+    case OP_CALLEXT: return 1 + ptr_words;
     case OP_TAGN: return 3;
     case OP_SETBIGGROUPNUM: return 2;
+    case OP_PACKED: return 2;
     default: return 1;
   }
 }
@@ -175,6 +364,15 @@ bool op_has_longofs(int32_t instruction) {
     case OP_CALL:
     case OP_BRANCH:
     case OP_CHECKDELIM:
+    case OP_FIELD1:
+    case OP_FIELD2:
+#define T(type) \
+    case OP_FIELD1_PARSE_ ## type: \
+    case OP_FIELD2_PARSE_ ## type: \
+    case OP_LOOP_PARSE_ ## type:
+    T(DOUBLE) T(FLOAT) T(INT64) T(UINT64) T(INT32) T(FIXED64) T(FIXED32)
+    T(BOOL) T(UINT32) T(SFIXED32) T(SFIXED64) T(SINT32) T(SINT64)
+#undef T
       return true;
     /* The "tag" instructions only have 8 bytes available for the jump target,
      * but that is ok because these opcodes only require short jumps. */
@@ -308,6 +506,7 @@ static void putop(compiler *c, opcode op, ...) {
     case OP_ENDSUBMSG:
     case OP_STARTSTR:
     case OP_STRING:
+    case OP_STRING_UTF8:
     case OP_ENDSTR:
     case OP_PUSHTAGDELIM:
       put32(c, op | va_arg(ap, upb_selector_t) << 8);
@@ -316,11 +515,49 @@ static void putop(compiler *c, opcode op, ...) {
       put32(c, op);
       put32(c, va_arg(ap, int));
       break;
+    case OP_PACKED:
+      put32(c, op | va_arg(ap, upb_selector_t) << 8);
+      put32(c, va_arg(ap, int));
+      break;
+    case OP_SEEN:
+      put32(c, op | va_arg(ap, uint32_t) << 8);
+      break;
     case OP_CALL: {
       const upb_pbdecodermethod *method = va_arg(ap, upb_pbdecodermethod *);
-      put32(c, op | (method->code_base.ofs - (pcofs(c) + 1)) << 8);
+      if (method->group != mgroup_upcast(c->group)) {
+        /* Method was linked from another group and already has an absolute
+         * address. */
+        uintptr_t ptr = (uintptr_t)method->code_base.ptr;
+        put32(c, OP_CALLEXT);
+        put32(c, ptr);
+        if (sizeof(uintptr_t) > sizeof(uint32_t))
+          put32(c, (uint64_t)ptr >> 32);
+      } else {
+        put32(c, op | (method->code_base.ofs - (pcofs(c) + 1)) << 8);
+      }
       break;
     }
+    case OP_CALLEXT:
+      /* Emitted by OP_CALL as appropriate. */
+      assert(false);
+      break;
+    case OP_RECORD:
+      /* Only used by the decoder's own program for delimited streams. */
+      assert(false);
+      break;
+#define T(type) \
+    case OP_FIELD1_PARSE_ ## type: \
+    case OP_FIELD2_PARSE_ ## type: \
+    case OP_LOOP_PARSE_ ## type:
+    T(DOUBLE) T(FLOAT) T(INT64) T(UINT64) T(INT32) T(FIXED64) T(FIXED32)
+    T(BOOL) T(UINT32) T(SFIXED32) T(SFIXED64) T(SINT32) T(SINT64)
+#undef T
+    case OP_FIELD1:
+    case OP_FIELD2:
+    case OP_STARTSTR_STRING:
+      /* Formed later by fuse_superops(). */
+      assert(false);
+      break;
     case OP_CHECKDELIM:
     case OP_BRANCH: {
       uint32_t instruction = op;
@@ -370,7 +607,13 @@ const char *upb_pbdecoder_getopname(unsigned int op) {
     OP(ENDSUBMSG) OP(STARTSTR) OP(STRING) OP(ENDSTR) OP(CALL) OP(RET)
     OP(PUSHLENDELIM) OP(PUSHTAGDELIM) OP(SETDELIM) OP(CHECKDELIM)
     OP(BRANCH) OP(TAG1) OP(TAG2) OP(TAGN) OP(SETDISPATCH) OP(POP)
-    OP(SETBIGGROUPNUM) OP(DISPATCH) OP(HALT)
+    OP(SETBIGGROUPNUM) OP(DISPATCH) OP(HALT) OP(CALLEXT)
+    OP(FIELD1) OP(FIELD2) OP(STARTSTR_STRING) OP(PACKED) OP(SEEN)
+    OP(RECORD) OP(STRING_UTF8)
+#undef T
+#define T(x) OP(FIELD1_PARSE_##x) OP(FIELD2_PARSE_##x) OP(LOOP_PARSE_##x)
+    T(DOUBLE) T(FLOAT) T(INT64) T(UINT64) T(INT32) T(FIXED64) T(FIXED32)
+    T(BOOL) T(UINT32) T(SFIXED32) T(SFIXED64) T(SINT32) T(SINT64)
   }
   return "<unknown op>";
 #undef OP
@@ -430,16 +673,40 @@ static void dumpbc(uint32_t *p, uint32_t *end, FILE *f) {
       case OP_ENDSUBMSG:
       case OP_STARTSTR:
       case OP_STRING:
+      case OP_STRING_UTF8:
       case OP_ENDSTR:
       case OP_PUSHTAGDELIM:
+      case OP_STARTSTR_STRING:
         fprintf(f, " %d", instr >> 8);
         break;
       case OP_SETBIGGROUPNUM:
         fprintf(f, " %d", *p++);
         break;
+      case OP_PACKED:
+        fprintf(f, " %d %s", instr >> 8, upb_pbdecoder_getopname(*p++));
+        break;
+      case OP_SEEN:
+        fprintf(f, " %d/%d", (instr >> 8) & 0xff, instr >> 16);
+        break;
+      case OP_CALLEXT: {
+        const uint32_t *target;
+        memcpy(&target, p, sizeof(void*));
+        p += ptr_words;
+        fprintf(f, " =>%p", (void*)target);
+        break;
+      }
       case OP_CHECKDELIM:
       case OP_CALL:
       case OP_BRANCH:
+      case OP_FIELD1:
+      case OP_FIELD2:
+#define T(type) \
+      case OP_FIELD1_PARSE_ ## type: \
+      case OP_FIELD2_PARSE_ ## type: \
+      case OP_LOOP_PARSE_ ## type:
+        T(DOUBLE) T(FLOAT) T(INT64) T(UINT64) T(INT32) T(FIXED64) T(FIXED32)
+        T(BOOL) T(UINT32) T(SFIXED32) T(SFIXED64) T(SINT32) T(SINT64)
+#undef T
         fprintf(f, " =>0x%tx", p + getofs(instr) - begin);
         break;
       case OP_TAG1:
@@ -544,15 +811,19 @@ static void putpush(compiler *c, const upb_fielddef *f) {
   }
 }
 
-static upb_pbdecodermethod *find_submethod(const compiler *c,
-                                           const upb_pbdecodermethod *method,
-                                           const upb_fielddef *f) {
+static const upb_pbdecodermethod *find_submethod(
+    const compiler *c, const upb_pbdecodermethod *method,
+    const upb_fielddef *f) {
   const upb_handlers *sub =
       upb_handlers_getsubhandlers(method->dest_handlers_, f);
   upb_value v;
-  return upb_inttable_lookupptr(&c->group->methods, sub, &v)
-             ? upb_value_getptr(v)
-             : NULL;
+  if (upb_inttable_lookupptr(&c->group->methods, sub, &v)) {
+    return upb_value_getptr(v);
+  } else if (upb_inttable_lookupptr(&c->linked, sub, &v)) {
+    return upb_value_getconstptr(v);
+  } else {
+    return NULL;
+  }
 }
 
 static void putsel(compiler *c, opcode op, upb_selector_t sel,
@@ -569,6 +840,15 @@ static void maybeput(compiler *c, opcode op, const upb_handlers *h,
   putsel(c, op, getsel(f, type), h);
 }
 
+/* Whether the field mask, if any, lets us decode "f".  Messages without any
+ * fields in the mask are decoded in full. */
+static bool selected(const compiler *c, const upb_fielddef *f) {
+  return !c->masked ||
+         upb_inttable_lookupptr(&c->maskfields, f, NULL) ||
+         !upb_inttable_lookupptr(&c->maskmsgs,
+                                 upb_fielddef_containingtype(f), NULL);
+}
+
 static bool haslazyhandlers(const upb_handlers *h, const upb_fielddef *f) {
   if (!upb_fielddef_lazy(f))
     return false;
@@ -578,6 +858,38 @@ static bool haslazyhandlers(const upb_handlers *h, const upb_fielddef *f) {
          upb_handlers_gethandler(h, getsel(f, UPB_HANDLER_ENDSTR));
 }
 
+/* Whether "f" has a handler of any kind, or subhandlers. */
+static bool hashandlers(const upb_handlers *h, const upb_fielddef *f) {
+  upb_handlertype_t type;
+  upb_selector_t sel;
+  if (upb_handlers_getsubhandlers(h, f)) return true;
+  for (type = UPB_HANDLER_INT32; type <= UPB_HANDLER_ENDSEQ; type++) {
+    if (upb_handlers_getselector(f, type, &sel) &&
+        upb_handlers_gethandler(h, sel)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Whether "f" is one of the fields that early exit waits for; see
+ * upb_pbdecodermethodopts_setearlyexit().  Message fields without a method
+ * get no code and so can never be seen. */
+static bool needed(const compiler *c, const upb_pbdecodermethod *method,
+                   const upb_fielddef *f) {
+  const upb_handlers *h = upb_pbdecodermethod_desthandlers(method);
+  if (!c->early_exit || upb_fielddef_isseq(f)) return false;
+  if (upb_fielddef_type(f) == UPB_TYPE_MESSAGE &&
+      !(haslazyhandlers(h, f) && c->lazy) && !find_submethod(c, method, f)) {
+    return false;
+  }
+  if (c->masked && upb_inttable_lookupptr(&c->maskmsgs, upb_handlers_msgdef(h),
+                                          NULL)) {
+    return upb_inttable_lookupptr(&c->maskfields, f, NULL);
+  }
+  return hashandlers(h, f);
+}
+
 
 /* bytecode compiler code generation ******************************************/
 
@@ -648,10 +960,18 @@ static void generate_msgfield(compiler *c, const upb_fielddef *f,
   }
 }
 
+/* Whether the values of "f" must be checked as UTF-8. */
+static bool checkutf8(const compiler *c, const upb_fielddef *f) {
+  return c->verify_utf8 &&
+         upb_fielddef_descriptortype(f) == UPB_DESCRIPTOR_TYPE_STRING &&
+         upb_msgdef_syntax(upb_fielddef_containingtype(f)) == UPB_SYNTAX_PROTO3;
+}
+
 /* Generates bytecode to parse a single string or lazy submessage field. */
 static void generate_delimfield(compiler *c, const upb_fielddef *f,
                                 upb_pbdecodermethod *method) {
   const upb_handlers *h = upb_pbdecodermethod_desthandlers(method);
+  opcode string_op = checkutf8(c, f) ? OP_STRING_UTF8 : OP_STRING;
 
   label(c, LABEL_FIELD);
   if (upb_fielddef_isseq(f)) {
@@ -664,7 +984,7 @@ static void generate_delimfield(compiler *c, const upb_fielddef *f,
     putop(c, OP_PUSHLENDELIM);
     putop(c, OP_STARTSTR, getsel(f, UPB_HANDLER_STARTSTR));
     /* Need to emit even if no handler to skip past the string. */
-    putop(c, OP_STRING, getsel(f, UPB_HANDLER_STRING));
+    putop(c, string_op, getsel(f, UPB_HANDLER_STRING));
     putop(c, OP_POP);
     maybeput(c, OP_ENDSTR, h, f, UPB_HANDLER_ENDSTR);
     putop(c, OP_SETDELIM);
@@ -680,7 +1000,7 @@ static void generate_delimfield(compiler *c, const upb_fielddef *f,
    dispatchtarget(c, method, f, UPB_WIRE_TYPE_DELIMITED);
     putop(c, OP_PUSHLENDELIM);
     putop(c, OP_STARTSTR, getsel(f, UPB_HANDLER_STARTSTR));
-    putop(c, OP_STRING, getsel(f, UPB_HANDLER_STRING));
+    putop(c, string_op, getsel(f, UPB_HANDLER_STRING));
     putop(c, OP_POP);
     maybeput(c, OP_ENDSTR, h, f, UPB_HANDLER_ENDSTR);
     putop(c, OP_SETDELIM);
@@ -717,10 +1037,15 @@ static void generate_primitivefield(compiler *c, const upb_fielddef *f,
    dispatchtarget(c, method, f, UPB_WIRE_TYPE_DELIMITED);
     putop(c, OP_PUSHLENDELIM);
     putop(c, OP_STARTSEQ, getsel(f, UPB_HANDLER_STARTSEQ));  /* Packed */
-   label(c, LABEL_LOOPSTART);
-    putop(c, parse_type, sel);
-    putop(c, OP_CHECKDELIM, LABEL_LOOPBREAK);
-    putop(c, OP_BRANCH, -LABEL_LOOPSTART);
+    if (upb_handlers_gethandler(h, upb_handlers_getarrayselector(sel))) {
+      putop(c, OP_PACKED, sel, parse_type);
+      putop(c, OP_BRANCH, LABEL_LOOPBREAK);
+    } else {
+     label(c, LABEL_LOOPSTART);
+      putop(c, parse_type, sel);
+      putop(c, OP_CHECKDELIM, LABEL_LOOPBREAK);
+      putop(c, OP_BRANCH, -LABEL_LOOPSTART);
+    }
    dispatchtarget(c, method, f, wire_type);
     putop(c, OP_PUSHTAGDELIM, 0);
     putop(c, OP_STARTSEQ, getsel(f, UPB_HANDLER_STARTSEQ));  /* Non-packed */
@@ -749,6 +1074,8 @@ static void compile_method(compiler *c, upb_pbdecodermethod *method) {
   uint32_t* start_pc;
   upb_msg_field_iter i;
   upb_value val;
+  uint32_t needed_count = 0;
+  uint32_t seen_bit = 0;
 
   assert(method);
 
@@ -759,6 +1086,16 @@ static void compile_method(compiler *c, upb_pbdecodermethod *method) {
   h = upb_pbdecodermethod_desthandlers(method);
   md = upb_handlers_msgdef(h);
 
+  for(upb_msg_field_begin(&i, md);
+      !upb_msg_field_done(&i);
+      upb_msg_field_next(&i)) {
+    if (needed(c, method, upb_msg_iter_field(&i))) needed_count++;
+  }
+  if (needed_count > 64) {
+    /* More than fit in upb_pbdecoder_frame.seen; never stop early. */
+    needed_count = 0;
+  }
+
  method->code_base.ofs = pcofs(c);
   putop(c, OP_SETDISPATCH, &method->dispatch);
   putsel(c, OP_STARTMSG, UPB_STARTMSG_SELECTOR, h);
@@ -770,6 +1107,12 @@ static void compile_method(compiler *c, upb_pbdecodermethod *method) {
     const upb_fielddef *f = upb_msg_iter_field(&i);
     upb_fieldtype_t type = upb_fielddef_type(f);
 
+    if (!selected(c, f)) {
+      /* Masked out: we emit no code, so the field is skipped like an unknown
+       * field (see upb_pbdecoder_skipunknown()). */
+      continue;
+    }
+
     if (type == UPB_TYPE_MESSAGE && !(haslazyhandlers(h, f) && c->lazy)) {
       generate_msgfield(c, f, method);
     } else if (type == UPB_TYPE_STRING || type == UPB_TYPE_BYTES ||
@@ -778,6 +1121,10 @@ static void compile_method(compiler *c, upb_pbdecodermethod *method) {
     } else {
       generate_primitivefield(c, f, method);
     }
+
+    if (needed_count > 0 && needed(c, method, f)) {
+      putop(c, OP_SEEN, seen_bit++ | needed_count << 8);
+    }
   }
 
   /* If there were no fields, or if no handlers were defined, we need to
@@ -805,17 +1152,49 @@ static void compile_method(compiler *c, upb_pbdecodermethod *method) {
   upb_inttable_compact(&method->dispatch);
 }
 
+/* If a method for "h" was previously compiled (with the same options) in
+ * another group, arranges for our bytecode to call it and returns true.  Its
+ * group is linked to ours, so that it lives at least as long as we do.  Only
+ * interpreted methods can be linked: bytecode can't call machine code. */
+static bool link_method(compiler *c, const upb_handlers *h) {
+  const upb_pbdecodermethod *m;
+  const mgroup *g;
+  keybuf buf;
+  methodkey *key;
+
+  if (!c->linkable) return false;
+  key = initkey(&buf, h, c->opts);
+  if (!key) return false;
+  m = lookupmethod(c->linkable, key);
+  freekey(&buf, key);
+  if (!m || m->is_native_) return false;
+
+  upb_inttable_insertptr(&c->linked, h, upb_value_constptr(m));
+  g = (const mgroup*)m->group;
+  if (!upb_inttable_lookupptr(&c->group->linked, g, NULL)) {
+    upb_inttable_insertptr(&c->group->linked, g, upb_value_bool(true));
+    mgroup_ref(g, c->group);
+  }
+  return true;
+}
+
 /* Populate "methods" with new upb_pbdecodermethod objects reachable from "h".
  * Returns the method for these handlers.
  *
- * Generates a new method for every destination handlers reachable from "h". */
+ * Generates a new method for every destination handlers reachable from "h",
+ * except those that can be linked from a previously compiled group.  Linked
+ * methods are already complete, so we don't need to look at their
+ * submessages. */
 static void find_methods(compiler *c, const upb_handlers *h) {
   upb_value v;
   upb_msg_field_iter i;
   const upb_msgdef *md;
 
-  if (upb_inttable_lookupptr(&c->group->methods, h, &v))
+  if (upb_inttable_lookupptr(&c->group->methods, h, &v) ||
+      upb_inttable_lookupptr(&c->linked, h, &v) ||
+      link_method(c, h)) {
     return;
+  }
   newmethod(h, c->group);
 
   /* Find submethods. */
@@ -825,10 +1204,11 @@ static void find_methods(compiler *c, const upb_handlers *h) {
       upb_msg_field_next(&i)) {
     const upb_fielddef *f = upb_msg_iter_field(&i);
     const upb_handlers *sub_h;
-    if (upb_fielddef_type(f) == UPB_TYPE_MESSAGE &&
+    if (upb_fielddef_type(f) == UPB_TYPE_MESSAGE && selected(c, f) &&
         (sub_h = upb_handlers_getsubhandlers(h, f)) != NULL) {
-      /* We only generate a decoder method for submessages with handlers.
-       * Others will be parsed as unknown fields. */
+      /* We only generate a decoder method for submessages with handlers that
+       * the field mask doesn't exclude.  Others will be skipped as unknown
+       * fields. */
       find_methods(c, sub_h);
     }
   }
@@ -849,14 +1229,260 @@ static void compile_methods(compiler *c) {
   }
 }
 
+
+
+/* Superinstructions. *********************************************************/
+
+/* Returns the superinstruction that can take the place of the instruction at
+ * "p", or its own opcode if there is none.  A superinstruction behaves exactly
+ * like the sequence it starts, so we don't need to know where the sequence
+ * came from. */
+static opcode superop(const uint32_t *p, const uint32_t *end) {
+  const uint32_t *next = p + instruction_len(*p);
+  opcode op = getop(*p);
+  opcode next_op;
+  opcode parse;
+
+  if (next == end) return op;
+  next_op = getop(*next);
+
+  if (op == OP_STARTSTR) {
+    return next_op == OP_STRING ? OP_STARTSTR_STRING : op;
+  } else if (op != OP_CHECKDELIM) {
+    return op;
+  }
+
+  switch (next_op) {
+    case OP_TAG1:
+    case OP_TAG2:
+      assert(next + 1 < end);
+      parse = getop(next[1]);
+      break;
+    case OP_BRANCH:
+      parse = getop(next[1 + getofs(*next)]);
+      break;
+    default:
+      return op;
+  }
+
+  switch (parse) {
+#define T(type) \
+    case OP_PARSE_ ## type: \
+      return next_op == OP_TAG1 ? OP_FIELD1_PARSE_ ## type : \
+             next_op == OP_TAG2 ? OP_FIELD2_PARSE_ ## type : \
+             OP_LOOP_PARSE_ ## type;
+    T(DOUBLE) T(FLOAT) T(INT64) T(UINT64) T(INT32) T(FIXED64) T(FIXED32)
+    T(BOOL) T(UINT32) T(SFIXED32) T(SFIXED64) T(SINT32) T(SINT64)
+#undef T
+    default:
+      return next_op == OP_TAG1 ? OP_FIELD1 :
+             next_op == OP_TAG2 ? OP_FIELD2 : op;
+  }
+}
+
+/* Peephole pass that replaces the first instruction of common sequences with a
+ * superinstruction, saving the interpreter a dispatch for each one.  The JIT
+ * doesn't dispatch between instructions, so it compiles the plain sequences. */
+static void fuse_superops(mgroup *g) {
+  uint32_t *p;
+  for (p = g->bytecode; p < g->bytecode_end; p += instruction_len(*p)) {
+    *p = (*p & ~0xff) | superop(p, g->bytecode_end);
+  }
+}
+
+
+/* Interpreter dispatch tables. ***********************************************/
+
+static int cmp_fieldnum(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t*)a;
+  uint32_t y = *(const uint32_t*)b;
+  return x < y ? -1 : x > y;
+}
+
+/* Tries to build a perfect hash for the keys with "size" slots and "buckets"
+ * buckets, as described in choosehash().  Returns false if some bucket could
+ * not be placed. */
+static bool tryhash(upb_pbdecoder_dispatchtable *t, const uint32_t *keys,
+                    size_t n, uint32_t size, uint32_t buckets) {
+  uint32_t *start = calloc(buckets + 1, sizeof(*start));
+  uint32_t *sorted = malloc(n * sizeof(*sorted));
+  bool *used = calloc(size, sizeof(*used));
+  uint32_t maxcount = 0;
+  uint32_t count;
+  uint32_t b;
+  size_t i;
+  bool ok = true;
+
+  t->seeds = malloc(buckets * sizeof(*t->seeds));
+  t->hash_size = size;
+  t->hash_buckets = buckets;
+
+  /* Sort the keys by bucket. */
+  for (i = 0; i < n; i++) {
+    start[(upb_pbdecoder_dispatchhash(keys[i], 0) & (buckets - 1)) + 1]++;
+  }
+  for (b = 0; b < buckets; b++) {
+    maxcount = UPB_MAX(maxcount, start[b + 1]);
+    start[b + 1] += start[b];
+  }
+  for (i = 0; i < n; i++) {
+    b = upb_pbdecoder_dispatchhash(keys[i], 0) & (buckets - 1);
+    sorted[start[b]++] = keys[i];
+  }
+  for (b = buckets; b > 0; b--) {
+    start[b] = start[b - 1];
+  }
+  start[0] = 0;
+
+  /* Place the biggest buckets first, while there are many free slots. */
+  for (count = maxcount; ok && count > 0; count--) {
+    for (b = 0; ok && b < buckets; b++) {
+      const uint32_t *k = sorted + start[b];
+      uint32_t seed;
+      uint32_t j;
+      if (start[b + 1] - start[b] != count) continue;
+
+      ok = false;
+      for (seed = 1; !ok && seed <= size * 64; seed++) {
+        for (j = 0; j < count; j++) {
+          uint32_t slot = upb_pbdecoder_dispatchhash(k[j], seed) & (size - 1);
+          if (used[slot]) break;
+          used[slot] = true;
+        }
+        if (j == count) {
+          t->seeds[b] = seed;
+          ok = true;
+        } else {
+          /* Undo the slots we took for this seed. */
+          while (j-- > 0) {
+            used[upb_pbdecoder_dispatchhash(k[j], seed) & (size - 1)] = false;
+          }
+        }
+      }
+    }
+  }
+
+  /* Buckets without keys can have any seed. */
+  for (b = 0; b < buckets; b++) {
+    if (start[b + 1] == start[b]) t->seeds[b] = 1;
+  }
+
+  if (!ok) {
+    free(t->seeds);
+    t->seeds = NULL;
+  }
+  free(start);
+  free(sorted);
+  free(used);
+  return ok;
+}
+
+/* Chooses a perfect hash for the keys ("hash and displace"): one hash splits
+ * the keys into buckets of about two keys each, then every bucket, largest
+ * first, is given a seed for a second hash that puts all of its keys into
+ * free slots.  We start with as many slots as keys, rounded up to a power of
+ * two, and double that in the unlikely case that some bucket can't be
+ * placed. */
+static void choosehash(upb_pbdecoder_dispatchtable *t, const uint32_t *keys,
+                       size_t n) {
+  uint32_t size = 1;
+  uint32_t buckets = 1;
+  while (size < n) size <<= 1;
+  while (buckets * 2 < n) buckets <<= 1;
+  while (!tryhash(t, keys, n, size, buckets)) size <<= 1;
+}
+
+/* Builds the compact dispatch table that the bytecode decoder uses from the
+ * method's "dispatch" inttable. */
+static void build_interp_dispatch(upb_pbdecodermethod *m) {
+  upb_pbdecoder_dispatchtable *t = &m->interp_dispatch;
+  size_t n = 0;
+  size_t hashstart;
+  size_t size;
+  size_t i;
+  uint32_t *keys = malloc(upb_inttable_count(&m->dispatch) * sizeof(*keys));
+  upb_inttable_iter iter;
+  upb_value v;
+  bool ok;
+
+  free(t->entries);
+  free(t->seeds);
+  memset(t, 0, sizeof(*t));
+
+  ok = upb_inttable_lookup(&m->dispatch, DISPATCH_ENDMSG, &v);
+  UPB_ASSERT_VAR(ok, ok);
+  t->endmsg_ofs = upb_value_getuint64(v);
+
+  upb_inttable_begin(&iter, &m->dispatch);
+  for (; !upb_inttable_done(&iter); upb_inttable_next(&iter)) {
+    uintptr_t key = upb_inttable_iter_key(&iter);
+    if (key != DISPATCH_ENDMSG && key <= UPB_MAX_FIELDNUMBER) {
+      keys[n++] = key;
+    }
+  }
+  qsort(keys, n, sizeof(*keys), cmp_fieldnum);
+
+  /* Index directly by the longest run of low field numbers that fills at
+   * least half of its array, and hash the rest. */
+  for (i = 0; i < n; i++) {
+    if ((i + 1) * 2 >= (size_t)keys[i] + 1) {
+      t->array_size = keys[i] + 1;
+    }
+  }
+  hashstart = 0;
+  while (hashstart < n && keys[hashstart] < t->array_size) hashstart++;
+  if (hashstart < n) {
+    choosehash(t, keys + hashstart, n - hashstart);
+  }
+
+  size = t->array_size + t->hash_size;
+  t->entries = malloc(size * sizeof(*t->entries));
+  for (i = 0; i < size; i++) {
+    t->entries[i].fieldnum = 0;
+    t->entries[i].ofs = 0;
+    t->entries[i].ofs2 = 0;
+    t->entries[i].wt1 = NO_WIRE_TYPE;
+    t->entries[i].wt2 = NO_WIRE_TYPE;
+  }
+
+  for (i = 0; i < n; i++) {
+    uint32_t fieldnum = keys[i];
+    upb_pbdecoder_dispatchentry *e;
+    uint64_t ofs;
+
+    if (i < hashstart) {
+      e = &t->entries[fieldnum];
+    } else {
+      e = &t->entries[t->array_size + upb_pbdecoder_dispatchslot(t, fieldnum)];
+    }
+
+    ok = upb_inttable_lookup(&m->dispatch, fieldnum, &v);
+    UPB_ASSERT_VAR(ok, ok);
+    upb_pbdecoder_unpackdispatch(upb_value_getuint64(v), &ofs, &e->wt1,
+                                 &e->wt2);
+    e->fieldnum = fieldnum;
+    e->ofs = ofs;
+    if (e->wt2 != NO_WIRE_TYPE) {
+      ok = upb_inttable_lookup(&m->dispatch, fieldnum + UPB_MAX_FIELDNUMBER,
+                               &v);
+      UPB_ASSERT_VAR(ok, ok);
+      e->ofs2 = upb_value_getuint64(v);
+    }
+  }
+
+  free(keys);
+}
+
 static void set_bytecode_handlers(mgroup *g) {
   upb_inttable_iter i;
+  fuse_superops(g);
   upb_inttable_begin(&i, &g->methods);
   for(; !upb_inttable_done(&i); upb_inttable_next(&i)) {
     upb_pbdecodermethod *m = upb_value_getptr(upb_inttable_iter_value(&i));
     upb_byteshandler *h = &m->input_handler_;
 
     m->code_base.ptr = g->bytecode + m->code_base.ofs;
+    build_interp_dispatch(m);
 
     upb_byteshandler_setstartstr(h, upb_pbdecoder_startbc, m->code_base.ptr);
     upb_byteshandler_setstring(h, upb_pbdecoder_decode, g);
@@ -869,9 +1495,37 @@ static void set_bytecode_handlers(mgroup *g) {
 
 #ifdef UPB_USE_JIT_X64
 
+/* Returns true if any of the group's bytecode uses "op". */
+static bool hasop(const mgroup *g, opcode op) {
+  const uint32_t *p;
+  for (p = g->bytecode; p < g->bytecode_end; p += instruction_len(*p)) {
+    if (getop(*p) == op) return true;
+  }
+  return false;
+}
+
+/* Returns true if any of the group's methods captures unknown fields. */
+static bool hasunknownhandler(const mgroup *g) {
+  upb_inttable_iter i;
+  upb_inttable_begin(&i, &g->methods);
+  for(; !upb_inttable_done(&i); upb_inttable_next(&i)) {
+    const upb_pbdecodermethod *m =
+        upb_value_getptr(upb_inttable_iter_value(&i));
+    if (m->dest_handlers_ &&
+        upb_handlers_gethandler(m->dest_handlers_, UPB_UNKNOWN_SELECTOR)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 static void sethandlers(mgroup *g, bool allowjit) {
   g->jit_code = NULL;
-  if (allowjit) {
+  /* The JIT has no OP_PACKED, OP_SEEN or OP_STRING_UTF8 yet, and its frames
+   * don't carry the sinks that unknown fields are delivered to.  Groups that
+   * need any of these are always interpreted. */
+  if (allowjit && !hasop(g, OP_PACKED) && !hasop(g, OP_SEEN) &&
+      !hasop(g, OP_STRING_UTF8) && !hasunknownhandler(g)) {
     /* Compile byte-code into machine code, create handlers. */
     upb_pbdecoder_jit(g);
   } else {
@@ -890,18 +1544,40 @@ static void sethandlers(mgroup *g, bool allowjit) {
 #endif  /* UPB_USE_JIT_X64 */
 
 
-/* TODO(haberman): allow this to be constructed for an arbitrary set of dest
- * handlers and other mgroups (but verify we have a transitive closure). */
-const mgroup *mgroup_new(const upb_handlers *dest, bool allowjit, bool lazy,
-                         const void *owner) {
+/* Freezing makes refcounting of the group and its methods thread-safe, so
+ * the methods can be shared between threads.  The group and its methods only
+ * point at each other, so the graph is never more than two deep. */
+static void freezegroup(mgroup *g) {
+  upb_refcounted *r = mgroup_upcast_mutable(g);
+  bool ok = upb_refcounted_freeze(&r, 1, NULL, 2);
+  UPB_ASSERT_VAR(ok, ok);
+}
+
+/* Compiles a new group containing a method for "dest" and for every
+ * destination handlers reachable from it.  If "linkable" is non-NULL, it maps
+ * method keys to methods of previously compiled groups; interpreted methods
+ * found there are called from the new group instead of being compiled again.
+ *
+ * TODO(haberman): allow this to be constructed for an arbitrary set of dest
+ * handlers (but verify we have a transitive closure). */
+const mgroup *mgroup_new(const upb_pbdecodermethodopts *opts, bool allowjit,
+                         const upb_strtable *linkable, const void *owner) {
+  const upb_handlers *dest = opts->handlers;
   mgroup *g;
   compiler *c;
 
   UPB_UNUSED(allowjit);
   assert(upb_handlers_isfrozen(dest));
 
+#ifdef UPB_USE_JIT_X64
+  /* The JIT emits all of a group's methods into one block of machine code and
+   * has no way to call into another group's code, so JIT groups are always
+   * compiled as a whole. */
+  if (allowjit) linkable = NULL;
+#endif
+
   g = newgroup(owner);
-  c = newcompiler(g, lazy);
+  c = newcompiler(g, opts, linkable);
   find_methods(c, dest);
 
   /* We compile in two passes:
@@ -932,25 +1608,671 @@ const mgroup *mgroup_new(const upb_handlers *dest, bool allowjit, bool lazy,
 #endif
 
   sethandlers(g, allowjit);
+  freezegroup(g);
+  return g;
+}
+
+
+/* bytecode images ************************************************************/
+
+/* A bytecode image is a group's bytecode and dispatch tables saved to a file,
+ * so that a later process can map it and start decoding without running the
+ * compiler.  The layout is:
+ *
+ *   imageheader
+ *   imagemethod[methods]
+ *   imageentry[dispatch_entries]  (every method's dispatch table, in order)
+ *   uint32_t[bytecode_words]
+ *
+ * Methods appear in the order that orderhandlers() visits their handlers,
+ * which depends only on the schema, so the loader can match them with the
+ * caller's handlers.  The only absolute pointers in the bytecode are the
+ * OP_SETDISPATCH operands; in the image these hold the index of the method
+ * instead, and are relocated when the image is loaded.
+ *
+ * Everything is in host byte order and pointer size, so an image can only be
+ * loaded on the same kind of machine that saved it.  The schema is identified
+ * by a fingerprint of everything that affects the generated code.  Beyond
+ * that images are trusted; we only check enough to avoid reading or writing
+ * outside of the image. */
+
+#define IMAGE_MAGIC "upbpbbc"
+#define IMAGE_VERSION 5  /* Bump whenever the bytecode changes. */
+
+typedef struct {
+  char magic[8];
+  uint32_t version;  /* Also catches a byte order mismatch. */
+  uint32_t ptrsize;
+  uint64_t fingerprint;
+  uint32_t lazy;
+  uint32_t early_exit;
+  uint32_t verify_utf8;
+  uint32_t methods;
+  uint32_t dispatch_entries;
+  uint32_t bytecode_words;
+} imageheader;
+
+typedef struct {
+  uint32_t code_ofs;
+  uint32_t dispatch_entries;
+} imagemethod;
+
+typedef struct {
+  uint64_t key;
+  uint64_t val;
+} imageentry;
+
+/* arch-specific image mapping ************************************************/
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* The mapping is private, so the pages that we relocate are copied on write
+ * and the rest are shared with the page cache. */
+static void *mapimage(const char *filename, size_t *size) {
+  struct stat st;
+  void *ret;
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) return NULL;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return NULL;
+  }
+  ret = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (ret == MAP_FAILED) return NULL;
+  *size = st.st_size;
+  return ret;
+}
+
+static void unmapimage(void *image, size_t size) {
+  munmap(image, size);
+}
+
+#else
+
+/* No mmap() here; read the whole file instead. */
+static void *mapimage(const char *filename, size_t *size) {
+  long len;
+  void *ret = NULL;
+  FILE *f = fopen(filename, "rb");
+  if (!f) return NULL;
+  if (fseek(f, 0, SEEK_END) == 0 && (len = ftell(f)) > 0 &&
+      fseek(f, 0, SEEK_SET) == 0 && (ret = malloc(len)) != NULL) {
+    if (fread(ret, len, 1, f) == 1) {
+      *size = len;
+    } else {
+      free(ret);
+      ret = NULL;
+    }
+  }
+  fclose(f);
+  return ret;
+}
+
+static void unmapimage(void *image, size_t size) {
+  UPB_UNUSED(size);
+  free(image);
+}
+
+#endif
+
+/* 64-bit FNV-1a. */
+static uint64_t hashbytes(uint64_t hash, const void *data, size_t len) {
+  const unsigned char *p = data;
+  const uint64_t prime = ((uint64_t)0x100 << 32) | 0x1b3;
+  size_t i;
+  for (i = 0; i < len; i++) {
+    hash ^= p[i];
+    hash *= prime;
+  }
+  return hash;
+}
+
+static uint64_t hash32(uint64_t hash, uint32_t val) {
+  return hashbytes(hash, &val, sizeof(val));
+}
+
+static const upb_handlers *handlersat(const upb_inttable *order, size_t i) {
+  upb_value v;
+  bool ok = upb_inttable_lookup(order, i, &v);
+  UPB_ASSERT_VAR(ok, ok);
+  return upb_value_getconstptr(v);
+}
+
+/* Appends "h" and all handlers reachable from it to the array "order", in a
+ * deterministic depth-first order.  "index" maps each handlers to its
+ * position in "order". */
+static void orderhandlers(const upb_handlers *h, upb_inttable *order,
+                          upb_inttable *index) {
+  upb_msg_field_iter i;
+
+  if (upb_inttable_lookupptr(index, h, NULL)) return;
+  upb_inttable_insertptr(index, h,
+                         upb_value_uint32(upb_inttable_count(order)));
+  upb_inttable_push(order, upb_value_constptr(h));
+
+  for(upb_msg_field_begin(&i, upb_handlers_msgdef(h));
+      !upb_msg_field_done(&i);
+      upb_msg_field_next(&i)) {
+    const upb_fielddef *f = upb_msg_iter_field(&i);
+    const upb_handlers *sub;
+    if (upb_fielddef_type(f) == UPB_TYPE_MESSAGE &&
+        (sub = upb_handlers_getsubhandlers(h, f)) != NULL) {
+      orderhandlers(sub, order, index);
+    }
+  }
+}
+
+/* Hashes everything about these handlers that affects the bytecode we
+ * generate for them: the fields of each message and their selectors, which
+ * handlers are registered, and which handlers each submessage goes to. */
+static uint64_t fingerprint(const upb_inttable *order,
+                            const upb_inttable *index) {
+  uint64_t hash = ((uint64_t)0xcbf29ce4 << 32) | 0x84222325;
+  size_t n;
+
+  for (n = 0; n < upb_inttable_count(order); n++) {
+    const upb_handlers *h = handlersat(order, n);
+    const upb_msgdef *md = upb_handlers_msgdef(h);
+    const char *name = upb_msgdef_fullname(md);
+    upb_msg_field_iter i;
+
+    hash = hashbytes(hash, name, strlen(name) + 1);
+    hash = hash32(hash, upb_handlers_gethandler(h, UPB_STARTMSG_SELECTOR) != 0);
+    hash = hash32(hash, upb_handlers_gethandler(h, UPB_ENDMSG_SELECTOR) != 0);
+    hash = hash32(hash, upb_handlers_gethandler(h, UPB_UNKNOWN_SELECTOR) != 0);
+
+    for(upb_msg_field_begin(&i, md);
+        !upb_msg_field_done(&i);
+        upb_msg_field_next(&i)) {
+      const upb_fielddef *f = upb_msg_iter_field(&i);
+      const upb_handlers *sub = NULL;
+      uint32_t subindex = UINT32_MAX;
+      int type;
+      upb_value v;
+
+      if (upb_fielddef_type(f) == UPB_TYPE_MESSAGE &&
+          (sub = upb_handlers_getsubhandlers(h, f)) != NULL &&
+          upb_inttable_lookupptr(index, sub, &v)) {
+        subindex = upb_value_getuint32(v);
+      }
+
+      hash = hash32(hash, upb_fielddef_number(f));
+      hash = hash32(hash, upb_fielddef_descriptortype(f));
+      hash = hash32(hash, upb_fielddef_label(f));
+      hash = hash32(hash, upb_fielddef_lazy(f));
+      hash = hash32(hash, upb_msgdef_syntax(md));
+      hash = hash32(hash, subindex);
+
+      for (type = 0; type < UPB_HANDLER_MAX; type++) {
+        upb_selector_t sel;
+        if (upb_handlers_getselector(f, (upb_handlertype_t)type, &sel)) {
+          hash = hash32(hash, sel);
+          hash = hash32(hash, upb_handlers_gethandler(h, sel) != 0);
+        }
+      }
+    }
+  }
+
+  return hash;
+}
+
+static const upb_pbdecodermethod *groupmethod(const mgroup *g,
+                                              const upb_handlers *h) {
+  upb_value v;
+  bool ok = upb_inttable_lookupptr(&g->methods, h, &v);
+  UPB_ASSERT_VAR(ok, ok);
+  return upb_value_getptr(v);
+}
+
+static bool writeall(FILE *f, const void *data, size_t len) {
+  return len == 0 || fwrite(data, len, 1, f) == 1;
+}
+
+bool upb_pbdecodermethod_save(const upb_pbdecodermethodopts *opts,
+                              const char *filename, upb_status *s) {
+  const mgroup *g;
+  size_t words;
+  uint32_t *code;
+  upb_inttable order, index, methodindex;
+  imageheader hdr;
+  uint32_t *p;
+  size_t n;
+  FILE *f = NULL;
+  bool ok;
+
+  /* A masked group lacks the methods for masked-out submessages, which the
+   * image format expects to find. */
+  if (opts->fieldmask_len > 0) {
+    upb_status_seterrmsg(s, "Bytecode images don't support field masks.");
+    return false;
+  }
+
+  /* We always compile a new group, since JIT groups don't keep their bytecode
+   * and cached groups may call into other groups. */
+  g = mgroup_new(opts, false, NULL, opts);
+  words = g->bytecode_end - g->bytecode;
+  code = malloc(words * sizeof(uint32_t));
+  ok = code != NULL;
+
+  upb_inttable_init(&order, UPB_CTYPE_CONSTPTR);
+  upb_inttable_init(&index, UPB_CTYPE_UINT32);
+  upb_inttable_init(&methodindex, UPB_CTYPE_UINT32);
+  orderhandlers(opts->handlers, &order, &index);
+
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, IMAGE_MAGIC, sizeof(hdr.magic));
+  hdr.version = IMAGE_VERSION;
+  hdr.ptrsize = sizeof(void*);
+  hdr.fingerprint = fingerprint(&order, &index);
+  hdr.lazy = opts->lazy;
+  hdr.early_exit = opts->early_exit;
+  hdr.verify_utf8 = opts->verify_utf8;
+  hdr.methods = upb_inttable_count(&order);
+  hdr.bytecode_words = words;
+  for (n = 0; n < hdr.methods; n++) {
+    const upb_pbdecodermethod *m = groupmethod(g, handlersat(&order, n));
+    hdr.dispatch_entries += upb_inttable_count(&m->dispatch);
+    upb_inttable_insertptr(&methodindex, &m->dispatch, upb_value_uint32(n));
+  }
+
+  /* Replace the dispatch table pointers with method indexes. */
+  if (ok) {
+    memcpy(code, g->bytecode, words * sizeof(uint32_t));
+    for (p = code; p < code + words; p += instruction_len(*p)) {
+      if (getop(*p) == OP_SETDISPATCH) {
+        const upb_inttable *dispatch;
+        upb_value v;
+        uintptr_t i;
+        memcpy(&dispatch, p + 1, sizeof(void*));
+        ok = upb_inttable_lookupptr(&methodindex, dispatch, &v);
+        UPB_ASSERT_VAR(ok, ok);
+        i = upb_value_getuint32(v);
+        memcpy(p + 1, &i, sizeof(void*));
+      }
+    }
+  }
+
+  ok = ok && (f = fopen(filename, "wb")) != NULL &&
+       writeall(f, &hdr, sizeof(hdr));
+  for (n = 0; ok && n < hdr.methods; n++) {
+    const upb_pbdecodermethod *m = groupmethod(g, handlersat(&order, n));
+    imagemethod im;
+    im.code_ofs = (uint32_t*)m->code_base.ptr - g->bytecode;
+    im.dispatch_entries = upb_inttable_count(&m->dispatch);
+    ok = writeall(f, &im, sizeof(im));
+  }
+  for (n = 0; ok && n < hdr.methods; n++) {
+    const upb_pbdecodermethod *m = groupmethod(g, handlersat(&order, n));
+    upb_inttable_iter i;
+    upb_inttable_begin(&i, &m->dispatch);
+    for(; ok && !upb_inttable_done(&i); upb_inttable_next(&i)) {
+      imageentry e;
+      e.key = upb_inttable_iter_key(&i);
+      e.val = upb_value_getuint64(upb_inttable_iter_value(&i));
+      ok = writeall(f, &e, sizeof(e));
+    }
+  }
+  ok = ok && writeall(f, code, words * sizeof(uint32_t));
+  if (f && fclose(f) != 0) ok = false;
+
+  if (!ok) {
+    upb_status_seterrf(s, "Couldn't write bytecode image: %s", filename);
+  }
+
+  upb_inttable_uninit(&order);
+  upb_inttable_uninit(&index);
+  upb_inttable_uninit(&methodindex);
+  free(code);
+  mgroup_unref(g, opts);
+  return ok;
+}
+
+/* Points the OP_SETDISPATCH instructions of a loaded image at the dispatch
+ * tables of our methods.  Returns false if the bytecode is malformed. */
+static bool relocate(mgroup *g, const upb_inttable *order) {
+  uint32_t *p = g->bytecode;
+  while (p < g->bytecode_end) {
+    opcode op = getop(*p);
+    int len = instruction_len(*p);
+    if (op > OP_MAX || op == OP_CALLEXT || len > g->bytecode_end - p) {
+      return false;
+    }
+    if (op == OP_SETDISPATCH) {
+      const upb_pbdecodermethod *m;
+      const upb_inttable *dispatch;
+      uintptr_t i;
+      memcpy(&i, p + 1, sizeof(void*));
+      if (i >= upb_inttable_count(order)) return false;
+      m = groupmethod(g, handlersat(order, i));
+      dispatch = &m->dispatch;
+      memcpy(p + 1, &dispatch, sizeof(void*));
+    }
+    p += len;
+  }
+  return true;
+}
+
+/* Builds a group for "opts" from the bytecode image in "filename", using the
+ * image in place.  Returns NULL and sets "s" if the image can't be read or
+ * doesn't match. */
+static const mgroup *loadgroup(const upb_pbdecodermethodopts *opts,
+                               const char *filename, upb_status *s,
+                               const void *owner) {
+  size_t size;
+  void *image = mapimage(filename, &size);
+  const imagemethod *im;
+  const imageentry *entry;
+  upb_inttable order, index;
+  imageheader hdr;
+  mgroup *g;
+  size_t n;
+  const char *err = NULL;
+
+  if (!image) {
+    upb_status_seterrf(s, "Couldn't read bytecode image: %s", filename);
+    return NULL;
+  }
+
+  g = newgroup(owner);
+  g->image = image;
+  g->image_size = size;
+  upb_inttable_init(&order, UPB_CTYPE_CONSTPTR);
+  upb_inttable_init(&index, UPB_CTYPE_UINT32);
+
+  if (size < sizeof(hdr)) {
+    err = "truncated";
+    goto done;
+  }
+  memcpy(&hdr, image, sizeof(hdr));
+  if (memcmp(hdr.magic, IMAGE_MAGIC, sizeof(hdr.magic)) != 0 ||
+      hdr.version != IMAGE_VERSION || hdr.ptrsize != sizeof(void*)) {
+    err = "not an image for this version of upb or this machine";
+    goto done;
+  }
+
+  orderhandlers(opts->handlers, &order, &index);
+  if (hdr.lazy != opts->lazy || hdr.early_exit != opts->early_exit ||
+      hdr.verify_utf8 != opts->verify_utf8 ||
+      hdr.methods != upb_inttable_count(&order) ||
+      hdr.fingerprint != fingerprint(&order, &index)) {
+    err = "saved for different handlers or options";
+    goto done;
+  }
+
+  if (hdr.dispatch_entries > size / sizeof(imageentry) ||
+      hdr.bytecode_words > size / sizeof(uint32_t) ||
+      size != sizeof(hdr) + hdr.methods * sizeof(imagemethod) +
+                  hdr.dispatch_entries * sizeof(imageentry) +
+                  hdr.bytecode_words * sizeof(uint32_t)) {
+    err = "wrong size";
+    goto done;
+  }
+
+  im = (const imagemethod*)((char*)image + sizeof(hdr));
+  entry = (const imageentry*)(im + hdr.methods);
+  g->bytecode = (uint32_t*)(entry + hdr.dispatch_entries);
+  g->bytecode_end = g->bytecode + hdr.bytecode_words;
+
+  for (n = 0; n < hdr.methods; n++, im++) {
+    upb_pbdecodermethod *m = newmethod(handlersat(&order, n), g);
+    const imageentry *end = entry + im->dispatch_entries;
+    if (im->code_ofs >= hdr.bytecode_words ||
+        im->dispatch_entries > hdr.dispatch_entries ||
+        end > (const imageentry*)g->bytecode) {
+      err = "corrupt";
+      goto done;
+    }
+    m->code_base.ofs = im->code_ofs;
+    for (; entry < end; entry++) {
+      upb_inttable_insert(&m->dispatch, entry->key,
+                          upb_value_uint64(entry->val));
+    }
+    upb_inttable_compact(&m->dispatch);
+  }
+
+  if (!relocate(g, &order)) {
+    err = "corrupt";
+    goto done;
+  }
+
+  sethandlers(g, false);
+  freezegroup(g);
+
+done:
+  upb_inttable_uninit(&order);
+  upb_inttable_uninit(&index);
+  if (err) {
+    upb_status_seterrf(s, "Bytecode image %s is %s", filename, err);
+    mgroup_unref(g, owner);
+    return NULL;
+  }
   return g;
 }
 
 
 /* upb_pbcodecache ************************************************************/
 
-void upb_pbcodecache_init(upb_pbcodecache *c) {
-  upb_inttable_init(&c->groups, UPB_CTYPE_CONSTPTR);
+/* arch-specific concurrency primitives ****************************************
+ *
+ * The cache's lookup table is published with read-copy-update: readers load
+ * the current table pointer without locking, while a writer (holding the lock)
+ * builds a modified copy and then publishes it.  Replaced tables are freed
+ * with the cache, so readers never need to announce themselves.  These
+ * primitives implement the lock, the publish/load of the table pointer, and
+ * the statistics and use counts that are updated without the lock. */
+
+#ifdef UPB_THREAD_UNSAFE /*---------------------------------------------------*/
+
+static bool newlock(void **l) {
+  *l = NULL;
+  return true;
+}
+static void freelock(void *l) { UPB_UNUSED(l); }
+static void lock(void *l) { UPB_UNUSED(l); }
+static void unlock(void *l) { UPB_UNUSED(l); }
+
+static const upb_strtable *loadtable(const upb_strtable *const *p) {
+  return *p;
+}
+static void publishtable(const upb_strtable **p, const upb_strtable *t) {
+  *p = t;
+}
+static void atomic_inc(size_t *a) { (*a)++; }
+static size_t atomic_get(const size_t *a) { return *a; }
+static void atomic_set(size_t *a, size_t val) { *a = val; }
+static void stat_inc(size_t *a) { (*a)++; }
+
+#elif defined(_WIN32) /*------------------------------------------------------*/
+
+#include <Windows.h>
+
+static bool newlock(void **l) {
+  CRITICAL_SECTION *cs = malloc(sizeof(*cs));
+  if (!cs) return false;
+  InitializeCriticalSection(cs);
+  *l = cs;
+  return true;
+}
+static void freelock(void *l) {
+  DeleteCriticalSection(l);
+  free(l);
+}
+static void lock(void *l) { EnterCriticalSection(l); }
+static void unlock(void *l) { LeaveCriticalSection(l); }
+
+static const upb_strtable *loadtable(const upb_strtable *const *p) {
+  return InterlockedCompareExchangePointer((PVOID volatile *)p, NULL, NULL);
+}
+static void publishtable(const upb_strtable **p, const upb_strtable *t) {
+  InterlockedExchangePointer((PVOID volatile *)p, (PVOID)t);
+}
+static void atomic_inc(size_t *a) {
+#ifdef _WIN64
+  InterlockedIncrement64((LONG64 volatile *)a);
+#else
+  InterlockedIncrement((LONG volatile *)a);
+#endif
+}
+static size_t atomic_get(const size_t *a) {
+  return (size_t)InterlockedCompareExchangePointer((PVOID volatile *)a, NULL,
+                                                   NULL);
+}
+static void atomic_set(size_t *a, size_t val) {
+  InterlockedExchangePointer((PVOID volatile *)a, (PVOID)val);
+}
+/* Aligned volatile accesses are atomic, and this avoids a locked instruction
+ * on the lookup fast path. */
+static void stat_inc(size_t *a) {
+  *(volatile size_t *)a = *(volatile size_t *)a + 1;
+}
+
+#elif defined(__GNUC__) || defined(__clang__) /*------------------------------*/
+
+#include <pthread.h>
+
+static bool newlock(void **l) {
+  pthread_mutex_t *m = malloc(sizeof(*m));
+  if (!m) return false;
+  if (pthread_mutex_init(m, NULL) != 0) {
+    free(m);
+    return false;
+  }
+  *l = m;
+  return true;
+}
+static void freelock(void *l) {
+  pthread_mutex_destroy(l);
+  free(l);
+}
+static void lock(void *l) { pthread_mutex_lock(l); }
+static void unlock(void *l) { pthread_mutex_unlock(l); }
+
+static const upb_strtable *loadtable(const upb_strtable *const *p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static void publishtable(const upb_strtable **p, const upb_strtable *t) {
+  __atomic_store_n(p, t, __ATOMIC_RELEASE);
+}
+static void atomic_inc(size_t *a) { __atomic_fetch_add(a, 1, __ATOMIC_RELAXED); }
+static size_t atomic_get(const size_t *a) {
+  return __atomic_load_n(a, __ATOMIC_RELAXED);
+}
+static void atomic_set(size_t *a, size_t val) {
+  __atomic_store_n(a, val, __ATOMIC_RELAXED);
+}
+/* A relaxed load and store rather than a read-modify-write, which would make
+ * every lookup contend for this cache line.  Concurrent hits may be lost. */
+static void stat_inc(size_t *a) {
+  __atomic_store_n(a, __atomic_load_n(a, __ATOMIC_RELAXED) + 1,
+                   __ATOMIC_RELAXED);
+}
+
+#else
+#error Concurrency primitives not defined for your platform/CPU.  \
+       Implement them or compile with UPB_THREAD_UNSAFE.
+#endif
+
+static void freetable(const upb_strtable *t) {
+  upb_strtable_uninit((upb_strtable*)t);
+  free((upb_strtable*)t);
+}
+
+/* Returns a newly-allocated copy of the given table, or NULL if we ran out of
+ * memory. */
+static upb_strtable *copytable(const upb_strtable *t) {
+  upb_strtable *ret = malloc(sizeof(*ret));
+  upb_strtable_iter i;
+
+  if (!ret) return NULL;
+  if (!upb_strtable_init(ret, UPB_CTYPE_CONSTPTR)) {
+    free(ret);
+    return NULL;
+  }
+
+  upb_strtable_begin(&i, t);
+  for(; !upb_strtable_done(&i); upb_strtable_next(&i)) {
+    if (!upb_strtable_insert2(ret, upb_strtable_iter_key(&i),
+                              upb_strtable_iter_keylength(&i),
+                              upb_strtable_iter_value(&i))) {
+      freetable(ret);
+      return NULL;
+    }
+  }
+  return ret;
+}
+
+/* Returns the number of bytes of code (bytecode or machine code) that this
+ * group is using. */
+static size_t codesize(const mgroup *g) {
+#ifdef UPB_USE_JIT_X64
+  if (g->jit_code) {
+    return g->jit_size;
+  }
+#endif
+  return (g->bytecode_end - g->bytecode) * sizeof(uint32_t);
+}
+
+void upb_pbdecodermethod_countuse(const upb_pbdecodermethod *m) {
+  atomic_inc(&((upb_pbdecodermethod*)m)->uses_);
+}
+
+/* A cache whose init failed has no method table; it can't compile anything
+ * and only needs to be uninit'd. */
+static bool initialized(const upb_pbcodecache *c) {
+  return c->methods != NULL;
+}
+
+bool upb_pbcodecache_init(upb_pbcodecache *c) {
+  upb_strtable *methods = malloc(sizeof(*methods));
+  c->methods = NULL;
   c->allow_jit_ = true;
+  c->jit_threshold_ = 0;
+  c->jit_budget_ = 0;
+  c->jit_bytes_ = 0;
+  c->hits_ = 0;
+  c->misses_ = 0;
+  c->compiled_bytes_ = 0;
+
+  if (!methods) return false;
+  if (!upb_strtable_init(methods, UPB_CTYPE_CONSTPTR)) goto err1;
+  if (!upb_inttable_init(&c->groups, UPB_CTYPE_CONSTPTR)) goto err2;
+  if (!upb_inttable_init(&c->retired, UPB_CTYPE_CONSTPTR)) goto err3;
+  if (!newlock(&c->lock)) goto err4;
+  c->methods = methods;
+  return true;
+
+err4:
+  upb_inttable_uninit(&c->retired);
+err3:
+  upb_inttable_uninit(&c->groups);
+err2:
+  upb_strtable_uninit(methods);
+err1:
+  free(methods);
+  return false;
 }
 
 void upb_pbcodecache_uninit(upb_pbcodecache *c) {
   upb_inttable_iter i;
+  if (!initialized(c)) return;
   upb_inttable_begin(&i, &c->groups);
   for(; !upb_inttable_done(&i); upb_inttable_next(&i)) {
     const mgroup *group = upb_value_getconstptr(upb_inttable_iter_value(&i));
     mgroup_unref(group, c);
   }
+  while (upb_inttable_count(&c->retired) > 0) {
+    freetable(upb_value_getconstptr(upb_inttable_pop(&c->retired)));
+  }
   upb_inttable_uninit(&c->groups);
+  upb_inttable_uninit(&c->retired);
+  freetable(c->methods);
+  freelock(c->lock);
 }
 
 bool upb_pbcodecache_allowjit(const upb_pbcodecache *c) {
@@ -958,25 +2280,301 @@ bool upb_pbcodecache_allowjit(const upb_pbcodecache *c) {
 }
 
 bool upb_pbcodecache_setallowjit(upb_pbcodecache *c, bool allow) {
-  if (upb_inttable_count(&c->groups) > 0)
+  if (!initialized(c) || upb_inttable_count(&c->groups) > 0)
     return false;
   c->allow_jit_ = allow;
   return true;
 }
 
+size_t upb_pbcodecache_jitthreshold(const upb_pbcodecache *c) {
+  return c->jit_threshold_;
+}
+
+bool upb_pbcodecache_setjitthreshold(upb_pbcodecache *c, size_t uses) {
+  if (!initialized(c) || upb_inttable_count(&c->groups) > 0)
+    return false;
+  c->jit_threshold_ = uses;
+  return true;
+}
+
+size_t upb_pbcodecache_jitbudget(const upb_pbcodecache *c) {
+  return c->jit_budget_;
+}
+
+bool upb_pbcodecache_setjitbudget(upb_pbcodecache *c, size_t bytes) {
+  if (!initialized(c) || upb_inttable_count(&c->groups) > 0)
+    return false;
+  c->jit_budget_ = bytes;
+  return true;
+}
+
+/* The statistics may be read while other threads update them. */
+
+size_t upb_pbcodecache_jitbytes(const upb_pbcodecache *c) {
+  return atomic_get(&c->jit_bytes_);
+}
+
+size_t upb_pbcodecache_hits(const upb_pbcodecache *c) {
+  return atomic_get(&c->hits_);
+}
+
+size_t upb_pbcodecache_misses(const upb_pbcodecache *c) {
+  return atomic_get(&c->misses_);
+}
+
+size_t upb_pbcodecache_compiledbytes(const upb_pbcodecache *c) {
+  return atomic_get(&c->compiled_bytes_);
+}
+
+/* Adds a new group to the cache and publishes a method table that includes
+ * all of its methods.  If "promote" is true the group is machine code, which
+ * replaces any interpreted method already cached for the same key.  Returns
+ * false if we ran out of memory, in which case the cache is unchanged and the
+ * caller still owns "g".  Must be called with the lock held. */
+static bool addgroup(upb_pbcodecache *c, const mgroup *g,
+                     const upb_pbdecodermethodopts *opts, bool promote) {
+  upb_inttable_iter i;
+  upb_strtable *t = copytable(c->methods);
+
+  if (!t) return false;
+
+  /* Every method in the group was compiled with the same options, so each one
+   * can satisfy a later request for its own handlers.  Methods that were
+   * already cached from an earlier group keep their existing entry. */
+  upb_inttable_begin(&i, &g->methods);
+  for(; !upb_inttable_done(&i); upb_inttable_next(&i)) {
+    const upb_pbdecodermethod *m =
+        upb_value_getptr(upb_inttable_iter_value(&i));
+    keybuf buf;
+    methodkey *key = initkey(&buf, m->dest_handlers_, opts);
+    const upb_pbdecodermethod *old;
+    bool ok = true;
+
+    if (!key) {
+      freetable(t);
+      return false;
+    }
+
+    old = lookupmethod(t, key);
+    if (old && promote && !old->is_native_) {
+      upb_strtable_remove2(t, (const char*)key, keysize(key), NULL);
+      old = NULL;
+    }
+    if (!old) {
+      ok = upb_strtable_insert2(t, (const char*)key, keysize(key),
+                                upb_value_constptr(m));
+    }
+    freekey(&buf, key);
+
+    if (!ok) {
+      freetable(t);
+      return false;
+    }
+  }
+
+  if (!upb_inttable_push(&c->groups, upb_value_constptr(g))) {
+    freetable(t);
+    return false;
+  }
+  if (!upb_inttable_push(&c->retired, upb_value_constptr(c->methods))) {
+    upb_inttable_pop(&c->groups);
+    freetable(t);
+    return false;
+  }
+
+  /* Readers that loaded the old table may still be using it, so it is only
+   * freed when the cache is. */
+  publishtable(&c->methods, t);
+  return true;
+}
+
+#ifdef UPB_USE_JIT_X64
+/* Whether "g" can be added to the machine code we have already generated. */
+static bool fitsbudget(const upb_pbcodecache *c, const mgroup *g) {
+  return c->jit_budget_ == 0 || c->jit_bytes_ + g->jit_size <= c->jit_budget_;
+}
+#endif
+
+/* Whether "m" is interpreted but has decoded enough messages to be worth
+ * JIT compiling.  Methods that were refused never are, so they stay on the
+ * lock-free path. */
+static bool ishot(const upb_pbcodecache *c, const upb_pbdecodermethod *m) {
+  return m->count_uses_ && !atomic_get(&m->jit_refused_) &&
+         atomic_get(&m->uses_) >= c->jit_threshold_;
+}
+
+/* Compiles machine code for the hot method "m" and publishes it in place of
+ * the interpreted methods of its group.  Returns the method that callers
+ * should now use, which is "m" itself if it can't be JIT compiled or its code
+ * doesn't fit in the budget.  Must be called with the lock held. */
+static const upb_pbdecodermethod *promote(upb_pbcodecache *c,
+                                          const upb_pbdecodermethod *m,
+                                          const upb_pbdecodermethodopts *opts,
+                                          const methodkey *key) {
+  upb_pbdecodermethod *mutable_m = (upb_pbdecodermethod*)m;
+
+  /* If we fail for lack of memory, this makes us look again only after
+   * another "jit_threshold_" messages. */
+  atomic_set(&mutable_m->uses_, 0);
+
+#ifdef UPB_USE_JIT_X64
+  {
+    const mgroup *g = mgroup_new(opts, true, NULL, c);
+    if (g->jit_code && fitsbudget(c, g)) {
+      if (!addgroup(c, g, opts, true)) {
+        /* Out of memory; try again after another "jit_threshold_" uses. */
+        mgroup_unref(g, c);
+        return m;
+      }
+      /* The interpreted group stays alive until the cache is destroyed, since
+       * decoders may still be using it. */
+      atomic_set(&c->jit_bytes_, c->jit_bytes_ + g->jit_size);
+      atomic_set(&c->compiled_bytes_, c->compiled_bytes_ + codesize(g));
+      return lookupmethod(c->methods, key);
+    }
+    mgroup_unref(g, c);
+  }
+#else
+  UPB_UNUSED(c);
+  UPB_UNUSED(opts);
+  UPB_UNUSED(key);
+#endif
+
+  atomic_set(&mutable_m->jit_refused_, 1);
+  return m;
+}
+
+/* Compiles a new group for these options and adds it to the cache.  Returns
+ * false if we ran out of memory.  Must be called with the lock held.
+ *
+ * With a JIT threshold the group is interpreted to start with, and promote()
+ * compiles it to machine code once it is hot.  Either way, machine code that
+ * doesn't fit in the JIT budget is thrown away and the group is interpreted
+ * instead. */
+static bool compilegroup(upb_pbcodecache *c,
+                         const upb_pbdecodermethodopts *opts) {
+  const mgroup *g = NULL;
+  atomic_inc(&c->misses_);
+
+#ifdef UPB_USE_JIT_X64
+  if (c->allow_jit_ && c->jit_threshold_ == 0) {
+    g = mgroup_new(opts, true, NULL, c);
+    if (g->jit_code && !fitsbudget(c, g)) {
+      mgroup_unref(g, c);
+      g = NULL;
+    }
+  }
+#endif
+
+  if (!g) {
+    g = mgroup_new(opts, false, c->methods, c);
+#ifdef UPB_USE_JIT_X64
+    if (c->allow_jit_ && c->jit_threshold_ > 0) {
+      /* The group isn't published yet, so nobody else can see these. */
+      upb_inttable_iter i;
+      upb_inttable_begin(&i, &g->methods);
+      for(; !upb_inttable_done(&i); upb_inttable_next(&i)) {
+        upb_pbdecodermethod *m = upb_value_getptr(upb_inttable_iter_value(&i));
+        m->count_uses_ = true;
+      }
+    }
+#endif
+  }
+
+  if (!addgroup(c, g, opts, false)) {
+    mgroup_unref(g, c);
+    return false;
+  }
+#ifdef UPB_USE_JIT_X64
+  if (g->jit_code) {
+    atomic_set(&c->jit_bytes_, c->jit_bytes_ + g->jit_size);
+  }
+#endif
+  atomic_set(&c->compiled_bytes_, c->compiled_bytes_ + codesize(g));
+  return true;
+}
+
 const upb_pbdecodermethod *upb_pbcodecache_getdecodermethod(
     upb_pbcodecache *c, const upb_pbdecodermethodopts *opts) {
-  upb_value v;
-  bool ok;
+  const upb_pbdecodermethod *ret;
+  keybuf buf;
+  methodkey *key;
+
+  if (!initialized(c)) return NULL;
+  key = initkey(&buf, opts->handlers, opts);
+  if (!key) return NULL;
+
+  /* Fast path: the method is already published; no locking required.  The
+   * method itself outlives the table we found it in. */
+  ret = lookupmethod(loadtable(&c->methods), key);
+  if (ret && !ishot(c, ret)) {
+    stat_inc(&c->hits_);
+    freekey(&buf, key);
+    return ret;
+  }
 
-  /* Right now we build a new DecoderMethod every time.
-   * TODO(haberman): properly cache methods by their true key. */
-  const mgroup *g = mgroup_new(opts->handlers, c->allow_jit_, opts->lazy, c);
-  upb_inttable_push(&c->groups, upb_value_constptr(g));
+  lock(c->lock);
+  /* Another thread may have compiled this method while we were waiting. */
+  ret = lookupmethod(c->methods, key);
+  if (ret) {
+    stat_inc(&c->hits_);
+    if (ishot(c, ret)) ret = promote(c, ret, opts, key);
+  } else if (compilegroup(c, opts)) {
+    ret = lookupmethod(c->methods, key);
+    assert(ret);
+  }
+  unlock(c->lock);
 
-  ok = upb_inttable_lookupptr(&g->methods, opts->handlers, &v);
-  UPB_ASSERT_VAR(ok, ok);
-  return upb_value_getptr(v);
+  freekey(&buf, key);
+  return ret;
+}
+
+const upb_pbdecodermethod *upb_pbcodecache_loaddecodermethod(
+    upb_pbcodecache *c, const upb_pbdecodermethodopts *opts,
+    const char *filename, upb_status *s) {
+  const upb_pbdecodermethod *ret;
+  keybuf buf;
+  methodkey *key;
+
+  if (!initialized(c)) {
+    upb_status_seterrmsg(s, "Out of memory");
+    return NULL;
+  } else if (opts->fieldmask_len > 0) {
+    upb_status_seterrmsg(s, "Bytecode images don't support field masks.");
+    return NULL;
+  }
+
+  key = initkey(&buf, opts->handlers, opts);
+  if (!key) {
+    upb_status_seterrmsg(s, "Out of memory");
+    return NULL;
+  }
+
+  ret = lookupmethod(loadtable(&c->methods), key);
+  if (ret) {
+    stat_inc(&c->hits_);
+    freekey(&buf, key);
+    return ret;
+  }
+
+  lock(c->lock);
+  ret = lookupmethod(c->methods, key);
+  if (ret) {
+    stat_inc(&c->hits_);
+  } else {
+    const mgroup *g = loadgroup(opts, filename, s, c);
+    if (g && !addgroup(c, g, opts, false)) {
+      upb_status_seterrmsg(s, "Out of memory");
+      mgroup_unref(g, c);
+    } else if (g) {
+      ret = lookupmethod(c->methods, key);
+      assert(ret);
+    }
+  }
+  unlock(c->lock);
+
+  freekey(&buf, key);
+  return ret;
 }
 
 
@@ -986,8 +2584,29 @@ void upb_pbdecodermethodopts_init(upb_pbdecodermethodopts *opts,
                                   const upb_handlers *h) {
   opts->handlers = h;
   opts->lazy = false;
+  opts->fieldmask = NULL;
+  opts->fieldmask_len = 0;
+  opts->early_exit = false;
+  opts->verify_utf8 = false;
 }
 
 void upb_pbdecodermethodopts_setlazy(upb_pbdecodermethodopts *opts, bool lazy) {
   opts->lazy = lazy;
 }
+
+void upb_pbdecodermethodopts_setfieldmask(upb_pbdecodermethodopts *opts,
+                                          const upb_fielddef *const *fields,
+                                          size_t n) {
+  opts->fieldmask = fields;
+  opts->fieldmask_len = n;
+}
+
+void upb_pbdecodermethodopts_setearlyexit(upb_pbdecodermethodopts *opts,
+                                          bool early_exit) {
+  opts->early_exit = early_exit;
+}
+
+void upb_pbdecodermethodopts_setverifyutf8(upb_pbdecodermethodopts *opts,
+                                           bool verify_utf8) {
+  opts->verify_utf8 = verify_utf8;
+}
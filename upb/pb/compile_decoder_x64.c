@@ -14,6 +14,10 @@
 #include "upb/pb/varint.int.h"
 #include "upb/shim/shim.h"
 
+#if !defined(__x86_64__)
+#error "The upb JIT only generates x86-64 code; build without UPB_USE_JIT_X64."
+#endif
+
 /* To debug the JIT:
  *
  * 1. Uncomment:
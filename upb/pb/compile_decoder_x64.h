@@ -1714,6 +1714,26 @@ static void jitbytecode(jitcompiler *jc) {
       dasm_put(Dst, 2448, jmptarget(jc, &method->dispatch));
 # 1132 "upb/pb/compile_decoder_x64.dasc"
       break;
+    case OP_CALLEXT:
+      /* Never emitted for JIT groups; see mgroup_new(). */
+#define T(type) \
+    case OP_FIELD1_PARSE_ ## type: \
+    case OP_FIELD2_PARSE_ ## type: \
+    case OP_LOOP_PARSE_ ## type:
+    T(DOUBLE) T(FLOAT) T(INT64) T(UINT64) T(INT32) T(FIXED64) T(FIXED32)
+    T(BOOL) T(UINT32) T(SFIXED32) T(SFIXED64) T(SINT32) T(SINT64)
+#undef T
+    case OP_FIELD1:
+    case OP_FIELD2:
+    case OP_STARTSTR_STRING:
+      /* Superinstructions are only formed for the interpreter; see
+       * set_bytecode_handlers(). */
+    case OP_PACKED:
+    case OP_SEEN:
+    case OP_STRING_UTF8:
+      /* Groups that use these are never JIT-compiled; see sethandlers(). */
+    case OP_RECORD:
+      /* Only used by the interpreter's program for delimited streams. */
     case OP_HALT:
       assert(false);
     }
@@ -1722,5 +1742,5 @@ static void jitbytecode(jitcompiler *jc) {
   asmlabel(jc, "eof");
   /*|  nop */
   dasm_put(Dst, 2206);
-# 1140 "upb/pb/compile_decoder_x64.dasc"
+# 1156 "upb/pb/compile_decoder_x64.dasc"
 }
@@ -24,6 +24,15 @@
 
 #define CHECK_SUSPEND(x) if (!(x)) return upb_pbdecoder_suspend(d);
 
+/* With GCC-compatible compilers the VM dispatches through a table of label
+ * addresses ("threaded code") instead of a switch().  Every op then ends with
+ * its own indirect jump, which gives the branch predictor one history per op
+ * instead of a single shared one.  Define UPB_NO_THREADED_VM to get the
+ * portable switch() loop. */
+#if defined(__GNUC__) && !defined(UPB_NO_THREADED_VM)
+#define UPB_THREADED_VM
+#endif
+
 /* Error messages that are shared between the bytecode and JIT decoders. */
 const char *kPbDecoderStackOverflow = "Nesting too deep.";
 const char *kPbDecoderSubmessageTooLong =
@@ -36,6 +45,18 @@ static const char *kUnterminatedVarint = "Unterminated varint.";
 
 static opcode halt = OP_HALT;
 
+/* The program we run instead of the method's code for delimited streams (see
+ * upb_pbdecoder_setdelimited()).  The stream ends wherever the user calls
+ * end(), so the top frame's end is only set then, like for a single message. */
+static const uint32_t records[] = {
+  OP_CHECKDELIM | 4 << 8,        /* 0: To OP_RET once the stream has ended. */
+  OP_RECORD,                     /* 1 */
+  OP_POP,                        /* 2 */
+  OP_SETDELIM,                   /* 3 */
+  OP_BRANCH | (uint32_t)-5 << 8, /* 4: Back to 0 for the next record. */
+  OP_RET                         /* 5 */
+};
+
 /* A dummy character we can point to when the user passes us a NULL buffer.
  * We need this because in C (NULL + 0) and (NULL - NULL) are undefined
  * behavior, which would invalidate functions like curbufleft(). */
@@ -59,14 +80,25 @@ static bool consumes_input(opcode op) {
     case OP_SETBIGGROUPNUM:
     case OP_CHECKDELIM:
     case OP_CALL:
+    case OP_CALLEXT:
     case OP_RET:
     case OP_BRANCH:
+    case OP_STARTSTR_STRING:
+    case OP_PACKED:  /* Checkpoints as it goes. */
+    case OP_SEEN:    /* Checkpoints if it skips. */
       return false;
     default:
       return true;
   }
 }
 
+/* Whether an op starts by doing OP_CHECKDELIM, which includes most of the
+ * superinstructions. */
+static bool is_checkdelim(opcode op) {
+  return op == OP_CHECKDELIM ||
+         (op >= OP_FIELD1_PARSE_DOUBLE && op <= OP_FIELD2);
+}
+
 static size_t stacksize(upb_pbdecoder *d, size_t entries) {
   UPB_UNUSED(d);
   return entries * sizeof(upb_pbdecoder_frame);
@@ -167,6 +199,7 @@ static void switchtobuf(upb_pbdecoder *d, const char *buf, const char *end) {
   d->ptr = buf;
   d->buf = buf;
   d->end = end;
+  d->handle = (buf == d->residual) ? NULL : d->handle_param;
   set_delim_end(d);
 }
 
@@ -200,6 +233,7 @@ static int32_t skip(upb_pbdecoder *d, size_t bytes) {
     /* Skipped data is all in current buffer, and more is still available. */
     advance(d, bytes);
     d->skip = 0;
+    d->skip_unknown = false;
     return DECODE_OK;
   } else {
     /* Skipped data extends beyond currently available buffers. */
@@ -208,10 +242,76 @@ static int32_t skip(upb_pbdecoder *d, size_t bytes) {
     d->bufstart_ofs += (d->end - d->buf);
     d->residual_end = d->residual;
     switchtobuf(d, d->residual, d->residual_end);
-    return d->size_param + d->skip;
+    /* Skipped bytes that we still have to deliver must not be skipped by the
+     * caller. */
+    return d->skip_unknown ? d->size_param : d->size_param + d->skip;
   }
 }
 
+/* Passes the next "n" bytes of an unknown field to the unknown field handler
+ * of "s".  The handler can't be resumed partway through a field, so failure
+ * is an error. */
+static int32_t putunknown(upb_pbdecoder *d, upb_sink *s, const char *buf,
+                          size_t n, const upb_bufhandle *handle) {
+  if (!upb_sink_putunknown(s, buf, n, handle)) {
+    seterr(d, "Unknown field handler failed.");
+    return upb_pbdecoder_suspend(d);
+  }
+  return DECODE_OK;
+}
+
+/* Returns the sink whose unknown field handler should receive the unknown
+ * field we are parsing, or NULL if it should just be skipped.  Unknown groups
+ * push frames of their own, so we look for the innermost frame of a known
+ * message.  JIT frames don't keep their sinks up to date, but the JIT is never
+ * used for handlers that capture unknown fields (see sethandlers()). */
+static upb_sink *unknown_sink(upb_pbdecoder *d) {
+  upb_pbdecoder_frame *fr = d->top;
+  if (d->method_->is_native_) return NULL;
+  while (fr->groupnum < 0) fr--;
+  if (!fr->sink.handlers ||
+      !upb_handlers_gethandler(fr->sink.handlers, UPB_UNKNOWN_SELECTOR)) {
+    return NULL;
+  }
+  return &fr->sink;
+}
+
+/* Whether the field we are skipping is a field of the message after all, that
+ * this method doesn't decode because of a field mask or because it has no
+ * subhandlers.  Such fields aren't unknown, so we don't pass them on.  Inside
+ * an unknown group, we look at the field that started the outermost group. */
+static bool knownfield(const upb_pbdecoder *d, const upb_sink *s,
+                       int32_t fieldnum, uint8_t wire_type) {
+  const upb_pbdecoder_frame *fr = d->top;
+  const upb_fielddef *f;
+  while (fr->groupnum < 0) {
+    fieldnum = -fr->groupnum;
+    wire_type = UPB_WIRE_TYPE_START_GROUP;
+    fr--;
+  }
+  f = upb_msgdef_itof(upb_handlers_msgdef(s->handlers), fieldnum);
+  if (!f) return false;
+  if (wire_type == upb_pb_native_wire_types[upb_fielddef_descriptortype(f)]) {
+    return true;
+  }
+  /* Packed. */
+  return wire_type == UPB_WIRE_TYPE_DELIMITED && upb_fielddef_isseq(f) &&
+         upb_fielddef_isprimitive(f);
+}
+
+/* Like skip(), but passes the skipped bytes to the unknown field sink "s".
+ * Bytes beyond the current buffer are passed as they arrive, when we resume. */
+static int32_t skipunknown_bytes(upb_pbdecoder *d, upb_sink *s, size_t bytes) {
+  if (bytes <= delim_remaining(d)) {
+    size_t avail = UPB_MIN(bytes, bufleft(d));
+    if (avail > 0) {
+      CHECK_RETURN(putunknown(d, s, d->ptr, avail, d->handle));
+    }
+    d->skip_unknown = true;
+  }
+  return skip(d, bytes);
+}
+
 
 /* Resumes the decoder from an initial state or from a previous suspend. */
 int32_t upb_pbdecoder_resume(upb_pbdecoder *d, void *p, const char *buf,
@@ -225,12 +325,20 @@ int32_t upb_pbdecoder_resume(upb_pbdecoder *d, void *p, const char *buf,
   /* We need to remember the original size_param, so that the value we return
    * is relative to it, even if we do some skipping first. */
   d->size_param = size;
-  d->handle = handle;
+  d->handle_param = handle;
 
   /* Have to handle this case specially (ie. not with skip()) because the user
    * is allowed to pass a NULL buffer here, which won't allow us to safely
    * calculate a d->end or use our normal functions like curbufleft(). */
   if (d->skip && d->skip >= size) {
+    if (d->skip_unknown && size > 0) {
+      upb_sink *s = unknown_sink(d);
+      if (!buf) {
+        seterr(d, "Passed NULL buffer over unknown field data.");
+        return upb_pbdecoder_suspend(d);
+      }
+      CHECK_RETURN(putunknown(d, s, buf, size, handle));
+    }
     d->skip -= size;
     d->bufstart_ofs += size;
     buf = &dummy_char;
@@ -254,6 +362,7 @@ int32_t upb_pbdecoder_resume(upb_pbdecoder *d, void *p, const char *buf,
   if (d->residual_end > d->residual) {
     /* We have residual bytes from the last buffer. */
     assert(d->ptr == d->residual);
+    d->handle = NULL;
   } else {
     switchtobuf(d, buf, buf + size);
   }
@@ -264,7 +373,11 @@ int32_t upb_pbdecoder_resume(upb_pbdecoder *d, void *p, const char *buf,
   if (d->skip) {
     size_t skip_bytes = d->skip;
     d->skip = 0;
-    CHECK_RETURN(skip(d, skip_bytes));
+    if (d->skip_unknown) {
+      CHECK_RETURN(skipunknown_bytes(d, unknown_sink(d), skip_bytes));
+    } else {
+      CHECK_RETURN(skip(d, skip_bytes));
+    }
     checkpoint(d);
   }
 
@@ -490,6 +603,141 @@ int32_t upb_pbdecoder_decode_f64(upb_pbdecoder *d, uint64_t *u64) {
 static double as_double(uint64_t n) { double d; memcpy(&d, &n, 8); return d; }
 static float  as_float(uint32_t n)  { float  f; memcpy(&f, &n, 4); return f; }
 
+/* How many values of a packed field we decode before passing them to the
+ * array handler. */
+#define PACKED_BATCH 64
+
+/* Converts "n" varints the way OP_PARSE_* "type" would and puts them to the
+ * field whose value selector is "sel". */
+static bool putpacked(upb_pbdecoder *d, upb_selector_t sel, opcode type,
+                      const uint64_t *raw, size_t n) {
+  upb_sink *s = &d->top->sink;
+  size_t i;
+  switch (type) {
+#define CONVERT(name, convfunc, ctype) { \
+      ctype vals[PACKED_BATCH]; \
+      for (i = 0; i < n; i++) vals[i] = (convfunc)(raw[i]); \
+      return upb_sink_put ## name ## array(s, sel, vals, n); \
+    }
+    case OP_PARSE_INT32:  CONVERT(int32,  int32_t,      int32_t)
+    case OP_PARSE_INT64:  CONVERT(int64,  int64_t,      int64_t)
+    case OP_PARSE_UINT32: CONVERT(uint32, uint32_t,     uint32_t)
+    case OP_PARSE_UINT64: return upb_sink_putuint64array(s, sel, raw, n);
+    case OP_PARSE_BOOL:   CONVERT(bool,   bool,         bool)
+    case OP_PARSE_SINT32: CONVERT(int32,  upb_zzdec_32, int32_t)
+    case OP_PARSE_SINT64: CONVERT(int64,  upb_zzdec_64, int64_t)
+#undef CONVERT
+    default:
+      assert(false);
+      return false;
+  }
+}
+
+/* Decodes the rest of a packed varint field a batch at a time.  We checkpoint
+ * after each batch, so suspending never delivers a value twice. */
+static int32_t decode_packed(upb_pbdecoder *d, upb_selector_t sel,
+                             opcode type) {
+  uint64_t raw[PACKED_BATCH];
+  while (d->ptr != d->delim_end) {
+    const char *end;
+    size_t n = upb_vdecode_run(d->ptr, d->data_end, raw, PACKED_BATCH, &end);
+    if (n > 0) {
+      advance(d, end - d->ptr);
+    } else {
+      /* The next varint spans a buffer seam or is malformed; the regular
+       * path handles both. */
+      CHECK_RETURN(decode_varint(d, &raw[0]));
+      n = 1;
+    }
+    CHECK_SUSPEND(putpacked(d, sel, type, raw, n));
+    checkpoint(d);
+  }
+  return DECODE_OK;
+}
+
+/* Puts "n" little-endian values of a fixed-width packed field, which must be
+ * aligned for their type, to the field whose value selector is "sel". */
+static bool putpackedfixed(upb_pbdecoder *d, upb_selector_t sel, opcode type,
+                           const void *vals, size_t n) {
+  upb_sink *s = &d->top->sink;
+  switch (type) {
+    case OP_PARSE_DOUBLE:
+      return upb_sink_putdoublearray(s, sel, (const double*)vals, n);
+    case OP_PARSE_FLOAT:
+      return upb_sink_putfloatarray(s, sel, (const float*)vals, n);
+    case OP_PARSE_FIXED64:
+      return upb_sink_putuint64array(s, sel, (const uint64_t*)vals, n);
+    case OP_PARSE_FIXED32:
+      return upb_sink_putuint32array(s, sel, (const uint32_t*)vals, n);
+    case OP_PARSE_SFIXED64:
+      return upb_sink_putint64array(s, sel, (const int64_t*)vals, n);
+    case OP_PARSE_SFIXED32:
+      return upb_sink_putint32array(s, sel, (const int32_t*)vals, n);
+    default:
+      assert(false);
+      return false;
+  }
+}
+
+/* Decodes the rest of a packed fixed32 or fixed64 field.  The values are
+ * already laid out on the wire the way the array handler wants them, so every
+ * whole value in the current buffer goes out in one call that points straight
+ * into the buffer.  We only copy when the buffer is misaligned for the type or
+ * a value spans a buffer seam. */
+static int32_t decode_packed_fixed(upb_pbdecoder *d, upb_selector_t sel,
+                                   opcode type, size_t size) {
+  uint64_t buf[PACKED_BATCH];
+  while (d->ptr != d->delim_end) {
+    size_t n = (d->data_end - d->ptr) / size;
+    if (n == 0) {
+      CHECK_RETURN(getbytes(d, buf, size));
+      n = 1;
+      CHECK_SUSPEND(putpackedfixed(d, sel, type, buf, n));
+    } else if (((uintptr_t)d->ptr & (size - 1)) == 0) {
+      const char *vals = d->ptr;
+      advance(d, n * size);
+      CHECK_SUSPEND(putpackedfixed(d, sel, type, vals, n));
+    } else {
+      n = UPB_MIN(n, sizeof(buf) / size);
+      memcpy(buf, d->ptr, n * size);
+      advance(d, n * size);
+      CHECK_SUSPEND(putpackedfixed(d, sel, type, buf, n));
+    }
+    checkpoint(d);
+  }
+  return DECODE_OK;
+}
+
+/* Sets d->limit to the last frame we can push without growing the stacks. */
+static void setlimit(upb_pbdecoder *d) {
+  d->limit = d->stack + UPB_MIN(d->stack_size, d->max_nesting) - 1;
+}
+
+/* Grows the stack and callstack to "entries" frames, keeping the frames that
+ * are in use. */
+static bool growstacks(upb_pbdecoder *d, size_t entries) {
+  size_t depth = d->top - d->stack;
+  void *p;
+
+  assert(entries > d->stack_size);
+  p = upb_env_realloc(d->env, d->stack, stacksize(d, d->stack_size),
+                      stacksize(d, entries));
+  if (!p) return false;
+  d->stack = p;
+  d->top = d->stack + depth;
+  setlimit(d);
+
+  /* If this fails the stack is bigger than we record, which is harmless. */
+  p = upb_env_realloc(d->env, d->callstack, callstacksize(d, d->stack_size),
+                      callstacksize(d, entries));
+  if (!p) return false;
+  d->callstack = p;
+
+  d->stack_size = entries;
+  setlimit(d);
+  return true;
+}
+
 /* Pushes a frame onto the decoder stack. */
 static bool decoder_push(upb_pbdecoder *d, uint64_t end) {
   upb_pbdecoder_frame *fr = d->top;
@@ -498,14 +746,23 @@ static bool decoder_push(upb_pbdecoder *d, uint64_t end) {
     seterr(d, kPbDecoderSubmessageTooLong);
     return false;
   } else if (fr == d->limit) {
-    seterr(d, kPbDecoderStackOverflow);
-    return false;
+    /* Only messages nested deeper than we have ever seen get here: grow the
+     * stacks if the nesting limit allows it. */
+    if (d->stack_size >= d->max_nesting) {
+      seterr(d, kPbDecoderStackOverflow);
+      return false;
+    } else if (!growstacks(d, UPB_MIN(d->stack_size * 2, d->max_nesting))) {
+      seterr(d, "Out of memory growing the decoder stack.");
+      return false;
+    }
+    fr = d->top;
   }
 
   fr++;
   fr->end_ofs = end;
   fr->dispatch = NULL;
   fr->groupnum = 0;
+  fr->seen = 0;
   d->top = fr;
   return true;
 }
@@ -541,8 +798,149 @@ UPB_NOINLINE int32_t upb_pbdecoder_checktag_slow(upb_pbdecoder *d,
   }
 }
 
+/* Checks for the one-byte tag in the arg of an OP_TAG1 instruction and consumes
+ * it if it matches.  Returns a status code as described in decoder.int.h. */
+UPB_FORCEINLINE static int32_t checktag1(upb_pbdecoder *d, uint32_t arg) {
+  uint8_t expected;
+  CHECK_SUSPEND(curbufleft(d) > 0);
+  expected = (arg >> 8) & 0xff;
+  if (*d->ptr == expected) {
+    advance(d, 1);
+    return DECODE_OK;
+  } else {
+    return DECODE_MISMATCH;
+  }
+}
+
+/* Like checktag1(), for the two-byte tag of an OP_TAG2 instruction. */
+UPB_FORCEINLINE static int32_t checktag2(upb_pbdecoder *d, uint32_t arg) {
+  uint16_t expected;
+  CHECK_SUSPEND(curbufleft(d) > 0);
+  expected = (arg >> 8) & 0xffff;
+  if (curbufleft(d) >= 2) {
+    uint16_t actual;
+    memcpy(&actual, d->ptr, 2);
+    if (expected == actual) {
+      advance(d, 2);
+      return DECODE_OK;
+    } else {
+      return DECODE_MISMATCH;
+    }
+  } else {
+    return upb_pbdecoder_checktag_slow(d, expected);
+  }
+}
+
+/* Returns the dispatch table entry for this field number, or NULL if the
+ * field is unknown.  The entry may still not match the wire type. */
+UPB_FORCEINLINE static const upb_pbdecoder_dispatchentry *lookup_dispatch(
+    const upb_pbdecoder_dispatchtable *t, uint32_t fieldnum) {
+  const upb_pbdecoder_dispatchentry *e;
+  if (fieldnum < t->array_size) {
+    return &t->entries[fieldnum];
+  } else if (t->hash_size == 0) {
+    return NULL;
+  }
+  e = &t->entries[t->array_size + upb_pbdecoder_dispatchslot(t, fieldnum)];
+  return e->fieldnum == fieldnum ? e : NULL;
+}
+
+/* The deepest nesting of unknown groups that skipfields() skips itself. */
+#define SKIP_MAX_GROUPS 32
+
+/* Fast path for skipping unknown fields that we don't pass on, while they are
+ * wholly in the current buffer.  Skips the value of the field whose tag we just
+ * read, including everything up to its END_GROUP tag if it is a group, without
+ * decoding any values or pushing any frames: varints are skipped by their
+ * continuation bits alone (see upb_vskip_fast()).  If "run" is true it keeps
+ * going over the fields that follow, until one that "t" knows (if "t" is
+ * non-NULL), so a run of unknown fields costs one call.
+ *
+ * Stops before anything the slow path has to handle: an END_GROUP tag for the
+ * current frame, a field that isn't wholly in the buffer, or malformed input,
+ * for which the slow path reports the error.  Returns a pointer just past the
+ * last field it skipped, or NULL if it couldn't skip even the first one. */
+static const char *skipfields(const upb_pbdecoder *d,
+                              const upb_pbdecoder_dispatchtable *t, bool run,
+                              uint32_t fieldnum, uint8_t wire_type) {
+  const char *p = d->ptr;
+  const char *end = d->data_end;
+  const char *ret = NULL;
+  uint32_t groups[SKIP_MAX_GROUPS];
+  /* The slow path would push a frame for each group. */
+  size_t max_depth = UPB_MIN(SKIP_MAX_GROUPS, (size_t)(d->limit - d->top));
+  size_t depth = 0;
+
+  while (true) {
+    upb_decoderet r;
+
+    switch (wire_type) {
+      case UPB_WIRE_TYPE_VARINT:
+        if (end - p < UPB_PB_VARINT_MAX_LEN) return ret;
+        p = upb_vskip_fast(p);
+        if (!p) return ret;
+        break;
+      case UPB_WIRE_TYPE_32BIT:
+      case UPB_WIRE_TYPE_64BIT: {
+        size_t bytes = (wire_type == UPB_WIRE_TYPE_32BIT) ? 4 : 8;
+        if ((size_t)(end - p) < bytes) return ret;
+        p += bytes;
+        break;
+      }
+      case UPB_WIRE_TYPE_DELIMITED:
+        if (end - p < UPB_PB_VARINT_MAX_LEN) return ret;
+        r = upb_vdecode_fast(p);
+        if (!r.p || r.val > (uint64_t)(end - r.p)) return ret;
+        p = r.p + r.val;
+        break;
+      case UPB_WIRE_TYPE_START_GROUP:
+        if (depth == max_depth) return ret;
+        groups[depth++] = fieldnum;
+        break;
+      case UPB_WIRE_TYPE_END_GROUP:
+        if (depth == 0 || groups[depth - 1] != fieldnum) return ret;
+        depth--;
+        break;
+      default:
+        return ret;
+    }
+
+    if (depth == 0) {
+      ret = p;
+      if (!run) return ret;
+    }
+
+    /* Next tag. */
+    if (end - p < UPB_PB_VARINT_MAX_LEN) return ret;
+    r = upb_vdecode_fast(p);
+    if (!r.p || r.val > UINT32_MAX) return ret;
+    fieldnum = (uint32_t)r.val >> 3;
+    wire_type = r.val & 0x7;
+    if (fieldnum == 0) return ret;
+    if (depth == 0 && t) {
+      const upb_pbdecoder_dispatchentry *e = lookup_dispatch(t, fieldnum);
+      if (e && (wire_type == e->wt1 || wire_type == e->wt2)) return ret;
+    }
+    p = r.p;
+  }
+}
+
 int32_t upb_pbdecoder_skipunknown(upb_pbdecoder *d, int32_t fieldnum,
                                   uint8_t wire_type) {
+  /* If the message wants its unknown fields, we pass each one on once we
+   * have parsed enough of it that we can't be rewound to its start: the tag
+   * and any value or length (re-encoded into "buf"), then the payload of
+   * delimited fields straight from the input. */
+  upb_sink *s = unknown_sink(d);
+  char buf[UPB_PB_VARINT_MAX_LEN * 2];
+  size_t n = 0;
+  /* Whether the fields after this one may be skipped too.  That takes the
+   * dispatch table, which JIT frames don't keep, unless we're in an unknown
+   * group where nothing is known. */
+  bool run = !s && (!d->method_->is_native_ || d->top->groupnum < 0);
+
+  if (s && knownfield(d, s, fieldnum, wire_type)) s = NULL;
+
   if (fieldnum >= 0)
     goto have_tag;
 
@@ -558,30 +956,60 @@ have_tag:
       return upb_pbdecoder_suspend(d);
     }
 
-    /* TODO: deliver to unknown field callback. */
+    if (!s && !in_residual_buf(d, d->ptr)) {
+      const char *p = skipfields(
+          d, d->top->groupnum < 0 ? NULL : d->top->dispatch, run, fieldnum,
+          wire_type);
+      if (p) {
+        advance(d, p - d->ptr);
+        if (d->top->groupnum >= 0) return DECODE_OK;
+        checkpoint(d);
+        continue;
+      }
+    }
+
+    if (s) n = upb_vencode64((uint64_t)fieldnum << 3 | wire_type, buf);
+
     switch (wire_type) {
       case UPB_WIRE_TYPE_32BIT:
-        CHECK_RETURN(skip(d, 4));
-        break;
-      case UPB_WIRE_TYPE_64BIT:
-        CHECK_RETURN(skip(d, 8));
+      case UPB_WIRE_TYPE_64BIT: {
+        size_t bytes = (wire_type == UPB_WIRE_TYPE_32BIT) ? 4 : 8;
+        if (s) {
+          CHECK_RETURN(getbytes(d, buf + n, bytes));
+          CHECK_RETURN(putunknown(d, s, buf, n + bytes, NULL));
+        } else {
+          CHECK_RETURN(skip(d, bytes));
+        }
         break;
+      }
       case UPB_WIRE_TYPE_VARINT: {
         uint64_t u64;
         CHECK_RETURN(decode_varint(d, &u64));
+        if (s) {
+          n += upb_vencode64(u64, buf + n);
+          CHECK_RETURN(putunknown(d, s, buf, n, NULL));
+        }
         break;
       }
       case UPB_WIRE_TYPE_DELIMITED: {
         uint32_t len;
         CHECK_RETURN(decode_v32(d, &len));
-        CHECK_RETURN(skip(d, len));
+        if (s && len <= delim_remaining(d)) {
+          n += upb_vencode64(len, buf + n);
+          CHECK_RETURN(putunknown(d, s, buf, n, NULL));
+          CHECK_RETURN(skipunknown_bytes(d, s, len));
+        } else {
+          CHECK_RETURN(skip(d, len));
+        }
         break;
       }
       case UPB_WIRE_TYPE_START_GROUP:
         CHECK_SUSPEND(pushtagdelim(d, -fieldnum));
+        if (s) CHECK_RETURN(putunknown(d, s, buf, n, NULL));
         break;
       case UPB_WIRE_TYPE_END_GROUP:
         if (fieldnum == -d->top->groupnum) {
+          if (s) CHECK_RETURN(putunknown(d, s, buf, n, NULL));
           decoder_pop(d);
         } else if (fieldnum == d->top->groupnum) {
           return DECODE_ENDGROUP;
@@ -605,10 +1033,34 @@ have_tag:
 }
 
 static void goto_endmsg(upb_pbdecoder *d) {
-  upb_value v;
-  bool found = upb_inttable_lookup32(d->top->dispatch, DISPATCH_ENDMSG, &v);
-  UPB_ASSERT_VAR(found, found);
-  d->pc = d->top->base + upb_value_getuint64(v);
+  d->pc = d->top->base + d->top->dispatch->endmsg_ofs;
+}
+
+/* Called by OP_SEEN once every needed field of the current message has been
+ * seen.  A submessage is skipped up to its end.  The top-level message has no
+ * end to skip to, so we consume all further input without parsing it and
+ * finish the message in upb_pbdecoder_end(). */
+static int32_t seenall(upb_pbdecoder *d) {
+  upb_pbdecoder_frame *fr = d->top;
+  if (fr->groupnum > 0) {
+    /* A group only ends at its END_GROUP tag, which we have to find. */
+    return DECODE_OK;
+  } else if (fr == d->stack) {
+    /* Like skip(), consume the rest of the buffer. */
+    assert(!in_residual_buf(d, d->ptr) || d->size_param == 0);
+    d->stopped = true;
+    d->bufstart_ofs += (d->end - d->buf);
+    d->residual_end = d->residual;
+    switchtobuf(d, d->residual, d->residual_end);
+    goto_endmsg(d);
+    return d->size_param;
+  } else {
+    const char *p = d->ptr;
+    CHECK_RETURN(skip(d, fr->end_ofs - offset(d)));
+    if (d->ptr != p) checkpoint(d);
+    goto_endmsg(d);
+    return DECODE_OK;
+  }
 }
 
 /* Parses a tag and jumps to the corresponding bytecode instruction for this
@@ -618,11 +1070,10 @@ static void goto_endmsg(upb_pbdecoder *d) {
  * unknown.  If the tag is a valid ENDGROUP tag, jumps to the bytecode
  * instruction for the end of message. */
 static int32_t dispatch(upb_pbdecoder *d) {
-  upb_inttable *dispatch = d->top->dispatch;
+  const upb_pbdecoder_dispatchentry *e;
   uint32_t tag;
   uint8_t wire_type;
   uint32_t fieldnum;
-  upb_value val;
   int32_t retval;
 
   /* Decode tag. */
@@ -631,18 +1082,15 @@ static int32_t dispatch(upb_pbdecoder *d) {
   fieldnum = tag >> 3;
 
   /* Lookup tag.  Because of packed/non-packed compatibility, we have to
-   * check the wire type against two possibilities. */
-  if (fieldnum != DISPATCH_ENDMSG &&
-      upb_inttable_lookup32(dispatch, fieldnum, &val)) {
-    uint64_t v = upb_value_getuint64(val);
-    if (wire_type == (v & 0xff)) {
-      d->pc = d->top->base + (v >> 16);
+   * check the wire type against two possibilities.  The DISPATCH_ENDMSG entry
+   * is never present, so field 0 can't match. */
+  e = lookup_dispatch(d->top->dispatch, fieldnum);
+  if (e) {
+    if (wire_type == e->wt1) {
+      d->pc = d->top->base + e->ofs;
       return DECODE_OK;
-    } else if (wire_type == ((v >> 8) & 0xff)) {
-      bool found =
-          upb_inttable_lookup(dispatch, fieldnum + UPB_MAX_FIELDNUMBER, &val);
-      UPB_ASSERT_VAR(found, found);
-      d->pc = d->top->base + upb_value_getuint64(val);
+    } else if (wire_type == e->wt2) {
+      d->pc = d->top->base + e->ofs2;
       return DECODE_OK;
     }
   }
@@ -653,7 +1101,7 @@ static int32_t dispatch(upb_pbdecoder *d) {
    * can re-check the delimited end. */
   d->last--;  /* Necessary if we get suspended */
   d->pc = d->last;
-  assert(getop(*d->last) == OP_CHECKDELIM);
+  assert(is_checkdelim(getop(*d->last)));
 
   /* Unknown field or ENDGROUP. */
   retval = upb_pbdecoder_skipunknown(d, fieldnum, wire_type);
@@ -676,48 +1124,304 @@ upb_pbdecoder_frame *outer_frame(upb_pbdecoder *d) {
 }
 
 
+/* Strings ********************************************************************/
+
+/* Checks the next "len" bytes of a string at "p" as UTF-8, continuing from the
+ * state in "d" and leaving it there for the next buffer.  Runs of ASCII, the
+ * common case, are checked sixteen bytes at a time.  Returns false if the
+ * bytes can't be part of a valid UTF-8 string. */
+static bool checkutf8(upb_pbdecoder *d, const char *p, size_t len) {
+  const uint8_t *ptr = (const uint8_t*)p;
+  const uint8_t *end = ptr + len;
+  uint8_t need = d->utf8_need;
+  uint8_t lo = d->utf8_lo;
+  uint8_t hi = d->utf8_hi;
+
+  while (ptr < end) {
+    uint8_t c;
+    if (need > 0) {
+      c = *ptr++;
+      if (c < lo || c > hi) return false;
+      need--;
+      lo = 0x80;
+      hi = 0xbf;
+      continue;
+    }
+
+    while (end - ptr >= 16) {
+      uint64_t w[2];
+      memcpy(w, ptr, sizeof(w));
+      if ((w[0] | w[1]) & 0x8080808080808080ULL) break;
+      ptr += 16;
+    }
+    if (ptr == end) break;
+
+    /* The ranges for the second byte exclude overlong encodings, surrogates
+     * and code points above U+10FFFF. */
+    c = *ptr++;
+    if (c < 0x80) {
+      continue;
+    } else if (c < 0xc2) {
+      return false;
+    } else if (c < 0xe0) {
+      need = 1;
+    } else if (c < 0xf0) {
+      need = 2;
+      lo = (c == 0xe0) ? 0xa0 : 0x80;
+      hi = (c == 0xed) ? 0x9f : 0xbf;
+    } else if (c < 0xf5) {
+      need = 3;
+      lo = (c == 0xf0) ? 0x90 : 0x80;
+      hi = (c == 0xf4) ? 0x8f : 0xbf;
+    } else {
+      return false;
+    }
+  }
+
+  d->utf8_need = need;
+  d->utf8_lo = lo;
+  d->utf8_hi = hi;
+  return true;
+}
+
+static void resetutf8(upb_pbdecoder *d) {
+  d->utf8_need = 0;
+  d->utf8_lo = 0x80;
+  d->utf8_hi = 0xbf;
+}
+
+/* Passes the string bytes in the current buffer to the string handler, for
+ * OP_STRING and (if "utf8") OP_STRING_UTF8.  Bytes are checked before the
+ * handler sees them, so if it takes fewer than it was offered, the ones it
+ * took are checked again from the saved state next time. */
+UPB_FORCEINLINE static int32_t putstring(upb_pbdecoder *d, uint32_t arg,
+                                         bool utf8) {
+  uint32_t len = curbufleft(d);
+  uint8_t need = d->utf8_need;
+  uint8_t lo = d->utf8_lo;
+  uint8_t hi = d->utf8_hi;
+  size_t n;
+
+  if (utf8 && !checkutf8(d, d->ptr, len)) {
+    seterr(d, "String field is not valid UTF-8.");
+    return upb_pbdecoder_suspend(d);
+  }
+
+  n = upb_sink_putstring(&d->top->sink, arg, d->ptr, len, d->handle);
+  if (n > len) {
+    if (n > delim_remaining(d)) {
+      seterr(d, "Tried to skip past end of string.");
+      return upb_pbdecoder_suspend(d);
+    } else {
+      int32_t ret;
+      /* The rest of the string is skipped unchecked. */
+      if (utf8) resetutf8(d);
+      ret = skip(d, n);
+      /* This shouldn't return DECODE_OK, because n > len. */
+      assert(ret >= 0);
+      return ret;
+    }
+  }
+  if (utf8 && n < len) {
+    d->utf8_need = need;
+    d->utf8_lo = lo;
+    d->utf8_hi = hi;
+    checkutf8(d, d->ptr, n);
+  }
+  advance(d, n);
+  if (n < len || d->delim_end == NULL) {
+    /* We aren't finished with this string yet. */
+    d->pc--;  /* Repeat OP_STRING. */
+    if (n > 0) checkpoint(d);
+    return upb_pbdecoder_suspend(d);
+  }
+  if (utf8 && d->utf8_need > 0) {
+    resetutf8(d);
+    seterr(d, "String field is not valid UTF-8.");
+    return upb_pbdecoder_suspend(d);
+  }
+  return DECODE_OK;
+}
+
+
 /* The main decoding loop *****************************************************/
 
 /* The main decoder VM function.  Uses traditional bytecode dispatch loop with a
- * switch() statement. */
-size_t run_decoder_vm(upb_pbdecoder *d, const mgroup *group,
-                      const upb_bufhandle* handle) {
-
+ * switch() statement, or threaded dispatch where available (see
+ * UPB_THREADED_VM above).  Both share the op bodies below. */
+size_t run_decoder_vm(upb_pbdecoder *d, const mgroup *group) {
+  int32_t instruction;
+  opcode op;
+  uint32_t arg;
+  int32_t longofs;
+
+#ifdef UPB_THREADED_VM
+  /* Indexed by opcode; must be kept in sync with the opcode enum in
+   * decoder.int.h.  Debug builds assert that each op lands on its own label. */
+  static const void *const labels[OP_MAX + 1] = {
+    __extension__ &&op_invalid,            /* 0 */
+    __extension__ &&op_OP_PARSE_DOUBLE,    /* 1 */
+    __extension__ &&op_OP_PARSE_FLOAT,     /* 2 */
+    __extension__ &&op_OP_PARSE_INT64,     /* 3 */
+    __extension__ &&op_OP_PARSE_UINT64,    /* 4 */
+    __extension__ &&op_OP_PARSE_INT32,     /* 5 */
+    __extension__ &&op_OP_PARSE_FIXED64,   /* 6 */
+    __extension__ &&op_OP_PARSE_FIXED32,   /* 7 */
+    __extension__ &&op_OP_PARSE_BOOL,      /* 8 */
+    __extension__ &&op_OP_STARTMSG,        /* 9 */
+    __extension__ &&op_OP_ENDMSG,          /* 10 */
+    __extension__ &&op_OP_STARTSEQ,        /* 11 */
+    __extension__ &&op_OP_ENDSEQ,          /* 12 */
+    __extension__ &&op_OP_PARSE_UINT32,    /* 13 */
+    __extension__ &&op_OP_STARTSUBMSG,     /* 14 */
+    __extension__ &&op_OP_PARSE_SFIXED32,  /* 15 */
+    __extension__ &&op_OP_PARSE_SFIXED64,  /* 16 */
+    __extension__ &&op_OP_PARSE_SINT32,    /* 17 */
+    __extension__ &&op_OP_PARSE_SINT64,    /* 18 */
+    __extension__ &&op_OP_ENDSUBMSG,       /* 19 */
+    __extension__ &&op_OP_STARTSTR,        /* 20 */
+    __extension__ &&op_OP_STRING,          /* 21 */
+    __extension__ &&op_OP_ENDSTR,          /* 22 */
+    __extension__ &&op_OP_PUSHTAGDELIM,    /* 23 */
+    __extension__ &&op_OP_PUSHLENDELIM,    /* 24 */
+    __extension__ &&op_OP_POP,             /* 25 */
+    __extension__ &&op_OP_SETDELIM,        /* 26 */
+    __extension__ &&op_OP_SETBIGGROUPNUM,  /* 27 */
+    __extension__ &&op_OP_CHECKDELIM,      /* 28 */
+    __extension__ &&op_OP_CALL,            /* 29 */
+    __extension__ &&op_OP_RET,             /* 30 */
+    __extension__ &&op_OP_BRANCH,          /* 31 */
+    __extension__ &&op_OP_TAG1,            /* 32 */
+    __extension__ &&op_OP_TAG2,            /* 33 */
+    __extension__ &&op_OP_TAGN,            /* 34 */
+    __extension__ &&op_OP_SETDISPATCH,     /* 35 */
+    __extension__ &&op_OP_DISPATCH,        /* 36 */
+    __extension__ &&op_OP_HALT,            /* 37 */
+    __extension__ &&op_OP_CALLEXT,         /* 38 */
+#define T(type) __extension__ &&op_OP_FIELD1_PARSE_ ## type,
+    T(DOUBLE) T(FLOAT) T(INT64) T(UINT64) T(INT32) T(FIXED64) T(FIXED32)
+    T(BOOL) T(UINT32) T(SFIXED32) T(SFIXED64) T(SINT32) T(SINT64)
+#undef T
+#define T(type) __extension__ &&op_OP_FIELD2_PARSE_ ## type,
+    T(DOUBLE) T(FLOAT) T(INT64) T(UINT64) T(INT32) T(FIXED64) T(FIXED32)
+    T(BOOL) T(UINT32) T(SFIXED32) T(SFIXED64) T(SINT32) T(SINT64)
+#undef T
+#define T(type) __extension__ &&op_OP_LOOP_PARSE_ ## type,
+    T(DOUBLE) T(FLOAT) T(INT64) T(UINT64) T(INT32) T(FIXED64) T(FIXED32)
+    T(BOOL) T(UINT32) T(SFIXED32) T(SFIXED64) T(SINT32) T(SINT64)
+#undef T
+    __extension__ &&op_OP_FIELD1,          /* 78 */
+    __extension__ &&op_OP_FIELD2,          /* 79 */
+    __extension__ &&op_OP_STARTSTR_STRING, /* 80 */
+    __extension__ &&op_OP_PACKED,          /* 81 */
+    __extension__ &&op_OP_SEEN,            /* 82 */
+    __extension__ &&op_OP_RECORD,          /* 83 */
+    __extension__ &&op_OP_STRING_UTF8,     /* 84 */
+  };
+
+/* "goto *" is a GNU extension; the statement expression lets us mark it as
+ * such so -pedantic stays quiet. */
+#define VMNEXT() \
+  do { VMFETCH(); __extension__ ({ goto *labels[op]; }); } while (0)
+#define VMCASE(op, code) \
+  op_ ## op: \
+  assert(getop(instruction) == op); \
+  { code; if (consumes_input(op)) checkpoint(d); VMNEXT(); }
+#define VMDONE() VMNEXT()
+#define VMLABEL(op)
+#else
 #define VMCASE(op, code) \
   case op: { code; if (consumes_input(op)) checkpoint(d); break; }
+#define VMDONE() break
+#define VMLABEL(op) op_ ## op:
+#endif
+
+/* Ends a superinstruction by running the next instruction of its sequence,
+ * "next", without going through dispatch. */
+#define VMFUSE(next) \
+  do { VMFETCH(); assert(op == next); goto op_ ## next; } while (0)
+
 #define PRIMITIVE_OP(type, wt, name, convfunc, ctype) \
+  VMLABEL(OP_PARSE_ ## type) \
   VMCASE(OP_PARSE_ ## type, { \
     ctype val; \
     CHECK_RETURN(decode_ ## wt(d, &val)); \
     upb_sink_put ## name(&d->top->sink, arg, (convfunc)(val)); \
   })
 
-  while(1) {
-    int32_t instruction;
-    opcode op;
-    uint32_t arg;
-    int32_t longofs;
-
-    d->last = d->pc;
-    instruction = *d->pc++;
-    op = getop(instruction);
-    arg = instruction >> 8;
-    longofs = arg;
-    assert(d->ptr != d->residual_end);
-    UPB_UNUSED(group);
+/* The OP_CHECKDELIM that starts most superinstructions.  Leaves the
+ * superinstruction if the delimited region has ended. */
+#define SUPER_CHECKDELIM() \
+  assert(!(d->delim_end && d->ptr > d->delim_end)); \
+  if (d->ptr == d->delim_end) { \
+    d->pc += longofs; \
+    VMDONE(); \
+  }
+
+#define FIELD_PARSE_OP(n, type) \
+  VMCASE(OP_FIELD ## n ## _PARSE_ ## type, { \
+    int32_t result; \
+    SUPER_CHECKDELIM(); \
+    VMFETCH(); \
+    assert(op == OP_TAG ## n); \
+    result = checktag ## n(d, arg); \
+    CHECK_RETURN(result); \
+    if (result == DECODE_MISMATCH) goto badtag; \
+    checkpoint(d); \
+    VMFUSE(OP_PARSE_ ## type); \
+  })
+
+#define LOOP_PARSE_OP(type) \
+  VMCASE(OP_LOOP_PARSE_ ## type, { \
+    SUPER_CHECKDELIM(); \
+    VMFETCH(); \
+    assert(op == OP_BRANCH); \
+    d->pc += longofs; \
+    VMFUSE(OP_PARSE_ ## type); \
+  })
+
+#define SUPER_OPS(type) \
+  FIELD_PARSE_OP(1, type) \
+  FIELD_PARSE_OP(2, type) \
+  LOOP_PARSE_OP(type)
+
 #ifdef UPB_DUMP_BYTECODE
-    fprintf(stderr, "s_ofs=%d buf_ofs=%d data_rem=%d buf_rem=%d delim_rem=%d "
-                    "%x %s (%d)\n",
-            (int)offset(d),
-            (int)(d->ptr - d->buf),
-            (int)(d->data_end - d->ptr),
-            (int)(d->end - d->ptr),
-            (int)((d->top->end_ofs - d->bufstart_ofs) - (d->ptr - d->buf)),
-            (int)(d->pc - 1 - group->bytecode),
-            upb_pbdecoder_getopname(op),
-            arg);
+#define VMTRACE() \
+    fprintf(stderr, "s_ofs=%d buf_ofs=%d data_rem=%d buf_rem=%d delim_rem=%d " \
+                    "%x %s (%d)\n", \
+            (int)offset(d), \
+            (int)(d->ptr - d->buf), \
+            (int)(d->data_end - d->ptr), \
+            (int)(d->end - d->ptr), \
+            (int)((d->top->end_ofs - d->bufstart_ofs) - (d->ptr - d->buf)), \
+            (int)(d->pc - 1 - group->bytecode), \
+            upb_pbdecoder_getopname(op), \
+            arg)
+#else
+#define VMTRACE()
 #endif
+
+#define VMFETCH() \
+  do { \
+    d->last = d->pc; \
+    instruction = *d->pc++; \
+    op = getop(instruction); \
+    arg = instruction >> 8; \
+    longofs = arg; \
+    assert(d->ptr != d->residual_end); \
+    VMTRACE(); \
+  } while (0)
+
+  UPB_UNUSED(group);
+
+#ifdef UPB_THREADED_VM
+  VMNEXT();
+  {
+#else
+  while(1) {
+    VMFETCH();
     switch (op) {
+#endif
       /* Technically, we are losing data if we see a 32-bit varint that is not
        * properly sign-extended.  We could detect this and error about the data
        * loss, but proto2 does not do this, so we pass. */
@@ -736,8 +1440,14 @@ size_t run_decoder_vm(upb_pbdecoder *d, const mgroup *group,
       PRIMITIVE_OP(SINT64,   varint,  int64,  upb_zzdec_64, uint64_t)
 
       VMCASE(OP_SETDISPATCH,
+        /* The operand is the method's "dispatch" inttable; we use the compact
+         * copy that lives alongside it. */
+        const char *dispatch;
         d->top->base = d->pc - 1;
-        memcpy(&d->top->dispatch, d->pc, sizeof(void*));
+        memcpy(&dispatch, d->pc, sizeof(void*));
+        d->top->dispatch = (const upb_pbdecoder_dispatchtable*)(
+            dispatch - offsetof(upb_pbdecodermethod, dispatch) +
+            offsetof(upb_pbdecodermethod, interp_dispatch));
         d->pc += sizeof(void*) / sizeof(uint32_t);
       )
       VMCASE(OP_STARTMSG,
@@ -768,27 +1478,12 @@ size_t run_decoder_vm(upb_pbdecoder *d, const mgroup *group,
           d->pc++;  /* Skip OP_STRING. */
         }
       )
+      VMLABEL(OP_STRING)
       VMCASE(OP_STRING,
-        uint32_t len = curbufleft(d);
-        size_t n = upb_sink_putstring(&d->top->sink, arg, d->ptr, len, handle);
-        if (n > len) {
-          if (n > delim_remaining(d)) {
-            seterr(d, "Tried to skip past end of string.");
-            return upb_pbdecoder_suspend(d);
-          } else {
-            int32_t ret = skip(d, n);
-            /* This shouldn't return DECODE_OK, because n > len. */
-            assert(ret >= 0);
-            return ret;
-          }
-        }
-        advance(d, n);
-        if (n < len || d->delim_end == NULL) {
-          /* We aren't finished with this string yet. */
-          d->pc--;  /* Repeat OP_STRING. */
-          if (n > 0) checkpoint(d);
-          return upb_pbdecoder_suspend(d);
-        }
+        CHECK_RETURN(putstring(d, arg, false));
+      )
+      VMCASE(OP_STRING_UTF8,
+        CHECK_RETURN(putstring(d, arg, true));
       )
       VMCASE(OP_ENDSTR,
         CHECK_SUSPEND(upb_sink_endstr(&d->top->sink, arg));
@@ -812,6 +1507,18 @@ size_t run_decoder_vm(upb_pbdecoder *d, const mgroup *group,
       VMCASE(OP_SETDELIM,
         set_delim_end(d);
       )
+      VMCASE(OP_RECORD,
+        /* Every record is delivered to the sink of the stream.  We copy it
+         * because decoder_push() may move the stack. */
+        upb_sink sink = d->top->sink;
+        uint32_t len;
+        CHECK_RETURN(decode_v32(d, &len));
+        CHECK_SUSPEND(decoder_push(d, offset(d) + len));
+        set_delim_end(d);
+        d->top->sink = sink;
+        d->callstack[d->call_len++] = d->pc;
+        d->pc = d->method_->code_base.ptr;
+      )
       VMCASE(OP_CHECKDELIM,
         /* We are guaranteed of this assert because we never allow ourselves to
          * consume bytes beyond data_end, which covers delim_end when non-NULL.
@@ -824,6 +1531,13 @@ size_t run_decoder_vm(upb_pbdecoder *d, const mgroup *group,
         d->callstack[d->call_len++] = d->pc;
         d->pc += longofs;
       )
+      VMCASE(OP_CALLEXT,
+        const uint32_t *target;
+        memcpy(&target, d->pc, sizeof(void*));
+        d->pc += sizeof(void*) / sizeof(uint32_t);
+        d->callstack[d->call_len++] = d->pc;
+        d->pc = target;
+      )
       VMCASE(OP_RET,
         assert(d->call_len > 0);
         d->pc = d->callstack[--d->call_len];
@@ -831,13 +1545,11 @@ size_t run_decoder_vm(upb_pbdecoder *d, const mgroup *group,
       VMCASE(OP_BRANCH,
         d->pc += longofs;
       )
+      VMLABEL(OP_TAG1)
       VMCASE(OP_TAG1,
-        uint8_t expected;
-        CHECK_SUSPEND(curbufleft(d) > 0);
-        expected = (arg >> 8) & 0xff;
-        if (*d->ptr == expected) {
-          advance(d, 1);
-        } else {
+        int32_t result = checktag1(d, arg);
+        CHECK_RETURN(result);
+        if (result == DECODE_MISMATCH) {
           int8_t shortofs;
          badtag:
           shortofs = arg;
@@ -845,27 +1557,15 @@ size_t run_decoder_vm(upb_pbdecoder *d, const mgroup *group,
             CHECK_RETURN(dispatch(d));
           } else {
             d->pc += shortofs;
-            break; /* Avoid checkpoint(). */
+            VMDONE(); /* Avoid checkpoint(). */
           }
         }
       )
+      VMLABEL(OP_TAG2)
       VMCASE(OP_TAG2,
-        uint16_t expected;
-        CHECK_SUSPEND(curbufleft(d) > 0);
-        expected = (arg >> 8) & 0xffff;
-        if (curbufleft(d) >= 2) {
-          uint16_t actual;
-          memcpy(&actual, d->ptr, 2);
-          if (expected == actual) {
-            advance(d, 2);
-          } else {
-            goto badtag;
-          }
-        } else {
-          int32_t result = upb_pbdecoder_checktag_slow(d, expected);
-          if (result == DECODE_MISMATCH) goto badtag;
-          if (result >= 0) return result;
-        }
+        int32_t result = checktag2(d, arg);
+        CHECK_RETURN(result);
+        if (result == DECODE_MISMATCH) goto badtag;
       )
       VMCASE(OP_TAGN, {
         uint64_t expected;
@@ -879,11 +1579,88 @@ size_t run_decoder_vm(upb_pbdecoder *d, const mgroup *group,
       VMCASE(OP_DISPATCH, {
         CHECK_RETURN(dispatch(d));
       })
+      VMCASE(OP_PACKED, {
+        opcode type = (opcode)*d->pc++;
+        switch (type) {
+          case OP_PARSE_DOUBLE:
+          case OP_PARSE_FIXED64:
+          case OP_PARSE_SFIXED64:
+            CHECK_RETURN(decode_packed_fixed(d, arg, type, 8));
+            break;
+          case OP_PARSE_FLOAT:
+          case OP_PARSE_FIXED32:
+          case OP_PARSE_SFIXED32:
+            CHECK_RETURN(decode_packed_fixed(d, arg, type, 4));
+            break;
+          default:
+            CHECK_RETURN(decode_packed(d, arg, type));
+        }
+      })
+      VMCASE(OP_SEEN, {
+        uint32_t count = arg >> 8;
+        d->top->seen |= (uint64_t)1 << (arg & 0xff);
+        if (d->top->seen == UINT64_MAX >> (64 - count)) {
+          CHECK_RETURN(seenall(d));
+        }
+      })
       VMCASE(OP_HALT, {
         return d->size_param;
       })
+
+      SUPER_OPS(DOUBLE)
+      SUPER_OPS(FLOAT)
+      SUPER_OPS(INT64)
+      SUPER_OPS(UINT64)
+      SUPER_OPS(INT32)
+      SUPER_OPS(FIXED64)
+      SUPER_OPS(FIXED32)
+      SUPER_OPS(BOOL)
+      SUPER_OPS(UINT32)
+      SUPER_OPS(SFIXED32)
+      SUPER_OPS(SFIXED64)
+      SUPER_OPS(SINT32)
+      SUPER_OPS(SINT64)
+
+      VMCASE(OP_FIELD1,
+        SUPER_CHECKDELIM();
+        VMFUSE(OP_TAG1);
+      )
+      VMCASE(OP_FIELD2,
+        SUPER_CHECKDELIM();
+        VMFUSE(OP_TAG2);
+      )
+      VMCASE(OP_STARTSTR_STRING,
+        uint32_t len = delim_remaining(d);
+        upb_pbdecoder_frame *outer = outer_frame(d);
+        CHECK_SUSPEND(upb_sink_startstr(&outer->sink, arg, len, &d->top->sink));
+        if (len == 0) {
+          d->pc++;  /* Skip OP_STRING. */
+          VMDONE();
+        }
+        VMFUSE(OP_STRING);
+      )
+#ifdef UPB_THREADED_VM
+     op_invalid:
+      assert(false);
+      return d->size_param;
+  }
+#else
     }
   }
+#endif
+
+#undef VMFETCH
+#undef VMTRACE
+#undef SUPER_OPS
+#undef LOOP_PARSE_OP
+#undef FIELD_PARSE_OP
+#undef SUPER_CHECKDELIM
+#undef PRIMITIVE_OP
+#undef VMFUSE
+#undef VMLABEL
+#undef VMDONE
+#undef VMCASE
+#undef VMNEXT
 }
 
 
@@ -896,8 +1673,13 @@ void *upb_pbdecoder_startbc(void *closure, const void *pc, size_t size_hint) {
   d->bufstart_ofs = 0;
   d->call_len = 1;
   d->callstack[0] = &halt;
-  d->pc = pc;
+  d->pc = d->delimited ? records : pc;
   d->skip = 0;
+  d->skip_unknown = false;
+  d->stopped = false;
+  d->top->seen = 0;
+  resetutf8(d);
+  if (d->method_->count_uses_) upb_pbdecodermethod_countuse(d->method_);
   return d;
 }
 
@@ -909,6 +1691,7 @@ void *upb_pbdecoder_startjit(void *closure, const void *hd, size_t size_hint) {
   d->bufstart_ofs = 0;
   d->call_len = 0;
   d->skip = 0;
+  d->skip_unknown = false;
   return d;
 }
 
@@ -916,19 +1699,19 @@ bool upb_pbdecoder_end(void *closure, const void *handler_data) {
   upb_pbdecoder *d = closure;
   const upb_pbdecodermethod *method = handler_data;
   uint64_t end;
-  char dummy;
+  char dummy = 0;
 
-  if (d->residual_end > d->residual) {
+  if (d->stopped) {
+    /* OP_SEEN ended the message early, and the rest of the input was never
+     * parsed; there is nothing left over to complain about. */
+    d->stopped = false;
+  } else if (d->residual_end > d->residual) {
     seterr(d, "Unexpected EOF: decoder still has buffered unparsed data");
     return false;
-  }
-
-  if (d->skip) {
+  } else if (d->skip) {
     seterr(d, "Unexpected EOF inside skipped data");
     return false;
-  }
-
-  if (d->top->end_ofs != UINT64_MAX) {
+  } else if (d->top->end_ofs != UINT64_MAX) {
     seterr(d, "Unexpected EOF inside delimited string");
     return false;
   }
@@ -947,16 +1730,17 @@ bool upb_pbdecoder_end(void *closure, const void *handler_data) {
 #endif
   {
     const uint32_t *p = d->pc;
+    opcode op = getop(*p);
     d->stack->end_ofs = end;
-    /* Check the previous bytecode, but guard against beginning. */
-    if (p != method->code_base.ptr) p--;
-    if (getop(*p) == OP_CHECKDELIM) {
-      /* Rewind from OP_TAG* to OP_CHECKDELIM. */
-      assert(getop(*d->pc) == OP_TAG1 ||
-             getop(*d->pc) == OP_TAG2 ||
-             getop(*d->pc) == OP_TAGN ||
-             getop(*d->pc) == OP_DISPATCH);
-      d->pc = p;
+    /* Rewind from OP_TAG* (or the OP_RECORD of a delimited stream) to
+     * OP_CHECKDELIM.  Only look at the previous word when we are at one of
+     * these: elsewhere it may be an operand (like the dispatch pointer of
+     * OP_SETDISPATCH) that merely looks like an OP_CHECKDELIM. */
+    if (op == OP_TAG1 || op == OP_TAG2 || op == OP_TAGN || op == OP_DISPATCH ||
+        op == OP_RECORD) {
+      /* Guard against beginning. */
+      if (p != method->code_base.ptr) p--;
+      if (is_checkdelim(getop(*p))) d->pc = p;
     }
     upb_pbdecoder_decode(closure, handler_data, &dummy, 0, NULL);
   }
@@ -971,12 +1755,21 @@ bool upb_pbdecoder_end(void *closure, const void *handler_data) {
 
 size_t upb_pbdecoder_decode(void *decoder, const void *group, const char *buf,
                             size_t size, const upb_bufhandle *handle) {
-  int32_t result = upb_pbdecoder_resume(decoder, NULL, buf, size, handle);
+  upb_pbdecoder *d = decoder;
+  int32_t result;
+
+  if (d->stopped) {
+    /* OP_SEEN ended the message early; see seenall(). */
+    d->bufstart_ofs += size;
+    return size;
+  }
+
+  result = upb_pbdecoder_resume(d, NULL, buf, size, handle);
 
-  if (result == DECODE_ENDGROUP) goto_endmsg(decoder);
+  if (result == DECODE_ENDGROUP) goto_endmsg(d);
   CHECK_RETURN(result);
 
-  return run_decoder_vm(decoder, group, handle);
+  return run_decoder_vm(d, group);
 }
 
 
@@ -985,15 +1778,18 @@ size_t upb_pbdecoder_decode(void *decoder, const void *group, const char *buf,
 void upb_pbdecoder_reset(upb_pbdecoder *d) {
   d->top = d->stack;
   d->top->groupnum = 0;
+  d->top->seen = 0;
+  d->stopped = false;
   d->ptr = d->residual;
   d->buf = d->residual;
   d->end = d->residual;
   d->residual_end = d->residual;
+  d->handle_param = NULL;
+  d->handle = NULL;
 }
 
 upb_pbdecoder *upb_pbdecoder_create(upb_env *e, const upb_pbdecodermethod *m,
                                     upb_sink *sink) {
-  const size_t default_max_nesting = 64;
 #ifndef NDEBUG
   size_t size_before = upb_env_bytesallocated(e);
 #endif
@@ -1002,16 +1798,18 @@ upb_pbdecoder *upb_pbdecoder_create(upb_env *e, const upb_pbdecodermethod *m,
   if (!d) return NULL;
 
   d->method_ = m;
-  d->callstack = upb_env_malloc(e, callstacksize(d, default_max_nesting));
-  d->stack = upb_env_malloc(e, stacksize(d, default_max_nesting));
+  d->callstack = upb_env_malloc(e, callstacksize(d, UPB_DECODER_MAX_NESTING));
+  d->stack = upb_env_malloc(e, stacksize(d, UPB_DECODER_MAX_NESTING));
   if (!d->stack || !d->callstack) {
     return NULL;
   }
 
   d->env = e;
-  d->limit = d->stack + default_max_nesting - 1;
-  d->stack_size = default_max_nesting;
+  d->stack_size = UPB_DECODER_MAX_NESTING;
+  d->max_nesting = UPB_DECODER_MAX_NESTING;
+  setlimit(d);
   d->status = NULL;
+  d->delimited = false;
 
   upb_pbdecoder_reset(d);
   upb_bytessink_reset(&d->input_, &m->input_handler_, d);
@@ -1041,7 +1839,7 @@ upb_bytessink *upb_pbdecoder_input(upb_pbdecoder *d) {
 }
 
 size_t upb_pbdecoder_maxnesting(const upb_pbdecoder *d) {
-  return d->stack_size;
+  return d->max_nesting;
 }
 
 bool upb_pbdecoder_setmaxnesting(upb_pbdecoder *d, size_t max) {
@@ -1052,27 +1850,28 @@ bool upb_pbdecoder_setmaxnesting(upb_pbdecoder *d, size_t max) {
     return false;
   }
 
-  if (max > d->stack_size) {
-    /* Need to reallocate stack and callstack to accommodate. */
-    size_t old_size = stacksize(d, d->stack_size);
-    size_t new_size = stacksize(d, max);
-    void *p = upb_env_realloc(d->env, d->stack, old_size, new_size);
-    if (!p) {
-      return false;
-    }
-    d->stack = p;
+#ifdef UPB_USE_JIT_X64
+  /* JIT code keeps the top frame in a register and can't follow the stack if
+   * it moves, so for native methods we allocate the whole stack up front. */
+  if (d->method_->is_native_ && max > d->stack_size && !growstacks(d, max)) {
+    return false;
+  }
+#endif
 
-    old_size = callstacksize(d, d->stack_size);
-    new_size = callstacksize(d, max);
-    p = upb_env_realloc(d->env, d->callstack, old_size, new_size);
-    if (!p) {
-      return false;
-    }
-    d->callstack = p;
+  d->max_nesting = max;
+  setlimit(d);
+  return true;
+}
 
-    d->stack_size = max;
-  }
+bool upb_pbdecoder_delimited(const upb_pbdecoder *d) {
+  return d->delimited;
+}
 
-  d->limit = d->stack + max - 1;
+bool upb_pbdecoder_setdelimited(upb_pbdecoder *d, bool delimited) {
+  if (delimited && d->method_->is_native_) {
+    /* The JIT has no program for delimited streams. */
+    return false;
+  }
+  d->delimited = delimited;
   return true;
 }
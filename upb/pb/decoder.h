@@ -25,6 +25,7 @@ class CodeCache;
 class Decoder;
 class DecoderMethod;
 class DecoderMethodOptions;
+class ParallelDecodeOptions;
 }  /* namespace pb */
 }  /* namespace upb */
 #endif
@@ -32,6 +33,7 @@ class DecoderMethodOptions;
 UPB_DECLARE_TYPE(upb::pb::CodeCache, upb_pbcodecache)
 UPB_DECLARE_TYPE(upb::pb::Decoder, upb_pbdecoder)
 UPB_DECLARE_TYPE(upb::pb::DecoderMethodOptions, upb_pbdecodermethodopts)
+UPB_DECLARE_TYPE(upb::pb::ParallelDecodeOptions, upb_pbparallelopts)
 
 UPB_DECLARE_DERIVED_TYPE(upb::pb::DecoderMethod, upb::RefCounted,
                          upb_pbdecodermethod, upb_refcounted)
@@ -56,13 +58,56 @@ class upb::pb::DecoderMethodOptions {
 
   /* Should the decoder push submessages to lazy handlers for fields that have
    * them?  The caller should set this iff the lazy handlers expect data that is
-   * in protobuf binary format and the caller wishes to lazy parse it. */
+   * in protobuf binary format and the caller wishes to lazy parse it.
+   *
+   * A lazy field is one with FieldDef::lazy() set and string handlers
+   * registered for it.  Its submessages are delivered undecoded to those
+   * handlers; DecoderMethod::FindSubMethod() gives the method to decode them
+   * with later. */
   void set_lazy(bool lazy);
+
+  /* Restricts decoding to the "n" given fields.  A field path like "a.b.c" is
+   * selected by including the fields for "a", "b" and "c".  In any message
+   * that has fields in the mask, fields not in the mask are skipped without
+   * being decoded or delivered; submessages are skipped by length, without
+   * descending into them.  A message with no fields in the mask (like the
+   * one under "c") is decoded in full.
+   *
+   * Since the mask is a set of fields and not of paths, it applies wherever a
+   * message type appears.  Every field must belong to a message reachable
+   * from the destination handlers.  The array is only read while a method is
+   * being looked up or compiled for these options.  Masked methods can't be
+   * saved to or loaded from bytecode images. */
+  void set_field_mask(const FieldDef* const* fields, size_t n);
+
+  /* Should the decoder stop as soon as it has seen every field it needs?  The
+   * needed fields of a message are its non-repeated fields in the field mask,
+   * or without a mask, its non-repeated fields that have handlers.  Once all
+   * of them have been seen, the rest of a submessage is skipped by length and
+   * the rest of the top-level message is consumed without being parsed, and
+   * so without being checked for errors.  This gives the wrong answer if the
+   * input repeats one of those fields later on, since the last value should
+   * win; only use it when the input is known to have each field once.
+   *
+   * Only messages with at most 64 needed fields are stopped early. */
+  void set_early_exit(bool early_exit);
+
+  /* Should the decoder check that the values of string fields declared in
+   * proto3 messages (see MessageDef::syntax()) are valid UTF-8, as proto3
+   * requires?  Invalid values are reported as an error through the decoder's
+   * environment, like any other malformed input.  Values are checked as they
+   * stream through, before they reach the string handlers; any bytes that a
+   * string handler asks to skip are not checked. */
+  void set_verify_utf8(bool verify_utf8);
 #else
 struct upb_pbdecodermethodopts {
 #endif
   const upb_handlers *handlers;
   bool lazy;
+  const upb_fielddef *const *fieldmask;
+  size_t fieldmask_len;
+  bool early_exit;
+  bool verify_utf8;
 };
 
 #ifdef __cplusplus
@@ -85,21 +130,88 @@ class upb::pb::DecoderMethod {
   /* Whether this method is native. */
   bool is_native() const;
 
+  /* The method that was compiled along with this one for the submessages of
+   * field "f", or NULL if "f" had no subhandlers.  Data that was delivered to
+   * the string handlers of a lazy field can be decoded later with it.  The
+   * returned method lives as long as this one does. */
+  const DecoderMethod* FindSubMethod(const FieldDef* f) const;
+
   /* Convenience method for generating a DecoderMethod without explicitly
    * creating a CodeCache. */
   static reffed_ptr<const DecoderMethod> New(const DecoderMethodOptions& opts);
 
+  /* Compiles bytecode for the given options and saves it to "filename" as an
+   * image that CodeCache::LoadDecoderMethod() can load later, possibly in
+   * another process.  Returns false and sets "status" if the file could not
+   * be written. */
+  static bool Save(const DecoderMethodOptions& opts, const char* filename,
+                   Status* status);
+
  private:
   UPB_DISALLOW_POD_OPS(DecoderMethod, upb::pb::DecoderMethod)
 };
 
 #endif
 
+/* Callbacks for decoding in parallel; see ParallelDecodeOptions below. */
+typedef bool upb_pbbatch_sinkfunc(void *closure, size_t batch, upb_sink *sink);
+typedef bool upb_pbbatch_mergefunc(void *closure, size_t batch);
+
+#ifdef __cplusplus
+
+/* The parameters for Decoder::DecodeParallel(), which decodes the elements of
+ * a large repeated submessage field on several threads.
+ *
+ * It works in two phases.  First, a quick scan of the top-level message finds
+ * the elements of "field" by their lengths alone, without decoding them, and
+ * splits them into batches of consecutive elements.  Then a pool of threads
+ * decodes the batches with "method", each batch into its own sink.  The other
+ * fields of the top-level message are skipped; decode them separately if
+ * needed, for example with a field mask. */
+class upb::pb::ParallelDecodeOptions {
+ public:
+  typedef upb_pbbatch_sinkfunc SinkFunc;
+  typedef upb_pbbatch_mergefunc MergeFunc;
+
+  /* "method" decodes one element of "field", which must be a repeated message
+   * field (not a group).  DecoderMethod::FindSubMethod() gives a suitable
+   * method.  Both must outlive the call to DecodeParallel(). */
+  ParallelDecodeOptions(const DecoderMethod* method, const FieldDef* field);
+
+  /* The number of threads to decode on; defaults to 1.  Without thread support
+   * (UPB_THREAD_UNSAFE, or on Windows), batches are always decoded on the
+   * calling thread. */
+  void set_threads(size_t threads);
+
+  /* The number of elements per batch; defaults to 1024. */
+  void set_batch_size(size_t elements);
+
+  /* Once the scan is done, "sink" is called for every batch, in order, on the
+   * calling thread.  It sets the sink that the batch's elements will be
+   * decoded into; each element gets its own start and end message callbacks.
+   * Since batches are decoded concurrently, the sinks shouldn't share state.
+   * "merge" is also called on the calling thread, for every batch in order,
+   * as soon as it and all earlier batches have been decoded.  Either callback
+   * can return false to stop decoding.  Both are required; decoding fails if
+   * they were never set. */
+  void set_callbacks(SinkFunc* sink, MergeFunc* merge, void* closure);
+#else
+struct upb_pbparallelopts {
+#endif
+  const upb_pbdecodermethod *method;
+  const upb_fielddef *field;
+  size_t threads;
+  size_t batch_size;
+  upb_pbbatch_sinkfunc *sink_func;
+  upb_pbbatch_mergefunc *merge_func;
+  void *closure;
+};
+
 /* Preallocation hint: decoder won't allocate more bytes than this when first
  * constructed.  This hint may be an overestimate for some build configurations.
  * But if the decoder library is upgraded without recompiling the application,
  * it may be an underestimate. */
-#define UPB_PB_DECODER_SIZE 4408
+#define UPB_PB_DECODER_SIZE 4944
 
 #ifdef __cplusplus
 
@@ -133,15 +245,36 @@ class upb::pb::Decoder {
   /* Gets/sets the parsing nexting limit.  If the total number of nested
    * submessages and repeated fields hits this limit, parsing will fail.  This
    * is a resource limit that controls the amount of memory used by the parsing
-   * stack.
+   * stack.  The default is 64, which the decoder allocates for up front; past
+   * that the stack grows from the decoder's upb::Environment as deeper nesting
+   * is actually seen (except for JIT-compiled methods, which allocate the
+   * whole stack when the limit is set).
    *
    * Setting the limit will fail if the parser is currently suspended at a depth
    * greater than this, or if memory allocation of the stack fails. */
   size_t max_nesting() const;
   bool set_max_nesting(size_t max);
 
+  /* Gets/sets whether the input is a stream of length-delimited records (as
+   * written by writeDelimitedTo()) instead of a single message.  Each record
+   * is a varint length followed by a message, which is delivered to the sink
+   * with its own start and end message callbacks.  The stream may end after
+   * any whole record.  Each record takes one level of nesting.
+   *
+   * Takes effect when the next stream starts, and stays set across Reset().
+   * Fails if the method is JIT-compiled. */
+  bool delimited() const;
+  bool set_delimited(bool delimited);
+
   void Reset();
 
+  /* Decodes the elements of a repeated submessage field of the message in
+   * "buf" on several threads; see ParallelDecodeOptions.  Returns false and
+   * sets "status" if the message or an element is malformed, or if a callback
+   * failed. */
+  static bool DecodeParallel(const ParallelDecodeOptions& opts,
+                             const char* buf, size_t len, Status* status);
+
   static const size_t kSize = UPB_PB_DECODER_SIZE;
 
  private:
@@ -155,7 +288,16 @@ class upb::pb::Decoder {
 /* A class for caching protobuf processing code, whether bytecode for the
  * interpreted decoder or machine code for the JIT.
  *
- * This class is not thread-safe.
+ * GetDecoderMethod() may be called concurrently from any number of threads
+ * (unless upb was built with UPB_THREAD_UNSAFE), so a single cache can be
+ * shared by a whole process.  Lookups of already-compiled methods take no
+ * locks.  Compiles are serialized, and a method that is requested by several
+ * threads at once is only compiled once.  The returned methods are frozen and
+ * may be used from any thread.  The other methods of this class, including
+ * construction and destruction, are not thread-safe.
+ *
+ * If construction runs out of memory, the cache is unusable: setters return
+ * false and GetDecoderMethod() returns NULL.
  *
  * TODO(haberman): move this to be heap allocated for ABI stability. */
 class upb::pb::CodeCache {
@@ -176,6 +318,27 @@ class upb::pb::CodeCache {
    * any code generation, otherwise returns false and does nothing. */
   bool set_allow_jit(bool allow);
 
+  /* Tiered compilation.  By default methods are JIT compiled as soon as they
+   * are first requested.  With a threshold, they are interpreted to start with
+   * and each method counts the messages it decodes; once a method has decoded
+   * "uses" messages, the next GetDecoderMethod() call for it compiles machine
+   * code and returns the native method from then on.  Callers that hold on to
+   * a method keep the interpreted one, so they should call GetDecoderMethod()
+   * again from time to time (it is cheap) to pick up the promotion.
+   *
+   * The budget caps the total size of the machine code this cache generates;
+   * methods whose code would exceed it stay interpreted.  0 means no limit,
+   * which is the default.  jit_bytes() is the machine code generated so far.
+   *
+   * Like set_allow_jit(), these may only be set before any code generation,
+   * otherwise they return false and do nothing.  They have no effect if the
+   * JIT isn't available. */
+  size_t jit_threshold() const;
+  bool set_jit_threshold(size_t uses);
+  size_t jit_budget() const;
+  bool set_jit_budget(size_t bytes);
+  size_t jit_bytes() const;
+
   /* Returns a DecoderMethod that can push data to the given handlers.
    * If a suitable method already exists, it will be returned from the cache.
    *
@@ -186,6 +349,27 @@ class upb::pb::CodeCache {
    * push data to the given handlers. */
   const DecoderMethod *GetDecoderMethod(const DecoderMethodOptions& opts);
 
+  /* Like GetDecoderMethod(), but if no suitable method is cached yet, loads it
+   * from an image written by DecoderMethod::Save() instead of compiling it.
+   * The image is mapped into memory and decoded from in place, which is much
+   * cheaper than compiling.  Loaded methods are always interpreted, even if
+   * allow_jit() is true.
+   *
+   * Returns NULL and sets "status" if the file can't be read, or if it was
+   * saved for a different schema, different handlers or options, or by a
+   * different version of upb or kind of machine. */
+  const DecoderMethod *LoadDecoderMethod(const DecoderMethodOptions& opts,
+                                         const char* filename, Status* status);
+
+  /* Cache statistics.  A hit is a GetDecoderMethod() call that was satisfied by
+   * previously generated code; a miss had to compile a new group of methods.
+   * compiled_bytes() is the total size of all bytecode or machine code that
+   * this cache has generated.  Hits are counted without synchronization, so
+   * lookups from several threads at once may undercount them. */
+  size_t hits() const;
+  size_t misses() const;
+  size_t compiled_bytes() const;
+
   /* If/when someone needs to explicitly create a dynamically-bound
    * DecoderMethod*, we can add a method to get it here. */
 
@@ -195,9 +379,28 @@ class upb::pb::CodeCache {
 struct upb_pbcodecache {
 #endif
   bool allow_jit_;
+  size_t jit_threshold_;
+  size_t jit_budget_;
+  size_t jit_bytes_;
 
-  /* Array of mgroups. */
+  /* Array of mgroups.  Only accessed while holding "lock". */
   upb_inttable groups;
+
+  /* Maps a method key (handlers + options, see compile_decoder.c) to an
+   * upb_pbdecodermethod in one of our groups.  A published table is never
+   * modified, so readers can use it without locking; writers publish a
+   * modified copy instead.  Readers may still be using a replaced table, so
+   * it is kept in "retired" until the cache is destroyed.  Tables are only
+   * replaced when a group is compiled, so there are few of them. */
+  const upb_strtable *methods;
+  upb_inttable retired;
+
+  /* Serializes compilation.  Opaque, platform-specific type. */
+  void *lock;
+
+  size_t hits_;
+  size_t misses_;
+  size_t compiled_bytes_;
 };
 
 UPB_BEGIN_EXTERN_C
@@ -210,11 +413,34 @@ upb_bytessink *upb_pbdecoder_input(upb_pbdecoder *d);
 uint64_t upb_pbdecoder_bytesparsed(const upb_pbdecoder *d);
 size_t upb_pbdecoder_maxnesting(const upb_pbdecoder *d);
 bool upb_pbdecoder_setmaxnesting(upb_pbdecoder *d, size_t max);
+bool upb_pbdecoder_delimited(const upb_pbdecoder *d);
+bool upb_pbdecoder_setdelimited(upb_pbdecoder *d, bool delimited);
 void upb_pbdecoder_reset(upb_pbdecoder *d);
+bool upb_pbdecoder_decodeparallel(const upb_pbparallelopts *opts,
+                                  const char *buf, size_t len,
+                                  upb_status *status);
 
 void upb_pbdecodermethodopts_init(upb_pbdecodermethodopts *opts,
                                   const upb_handlers *h);
 void upb_pbdecodermethodopts_setlazy(upb_pbdecodermethodopts *opts, bool lazy);
+void upb_pbdecodermethodopts_setfieldmask(upb_pbdecodermethodopts *opts,
+                                          const upb_fielddef *const *fields,
+                                          size_t n);
+void upb_pbdecodermethodopts_setearlyexit(upb_pbdecodermethodopts *opts,
+                                          bool early_exit);
+void upb_pbdecodermethodopts_setverifyutf8(upb_pbdecodermethodopts *opts,
+                                           bool verify_utf8);
+
+void upb_pbparallelopts_init(upb_pbparallelopts *opts,
+                             const upb_pbdecodermethod *m,
+                             const upb_fielddef *f);
+void upb_pbparallelopts_setthreads(upb_pbparallelopts *opts, size_t threads);
+void upb_pbparallelopts_setbatchsize(upb_pbparallelopts *opts,
+                                     size_t elements);
+void upb_pbparallelopts_setcallbacks(upb_pbparallelopts *opts,
+                                     upb_pbbatch_sinkfunc *sink,
+                                     upb_pbbatch_mergefunc *merge,
+                                     void *closure);
 
 
 /* Include refcounted methods like upb_pbdecodermethod_ref(). */
@@ -225,15 +451,30 @@ const upb_handlers *upb_pbdecodermethod_desthandlers(
 const upb_byteshandler *upb_pbdecodermethod_inputhandler(
     const upb_pbdecodermethod *m);
 bool upb_pbdecodermethod_isnative(const upb_pbdecodermethod *m);
+const upb_pbdecodermethod *upb_pbdecodermethod_submethod(
+    const upb_pbdecodermethod *m, const upb_fielddef *f);
 const upb_pbdecodermethod *upb_pbdecodermethod_new(
     const upb_pbdecodermethodopts *opts, const void *owner);
+bool upb_pbdecodermethod_save(const upb_pbdecodermethodopts *opts,
+                              const char *filename, upb_status *s);
 
-void upb_pbcodecache_init(upb_pbcodecache *c);
+bool upb_pbcodecache_init(upb_pbcodecache *c);
 void upb_pbcodecache_uninit(upb_pbcodecache *c);
 bool upb_pbcodecache_allowjit(const upb_pbcodecache *c);
 bool upb_pbcodecache_setallowjit(upb_pbcodecache *c, bool allow);
+size_t upb_pbcodecache_jitthreshold(const upb_pbcodecache *c);
+bool upb_pbcodecache_setjitthreshold(upb_pbcodecache *c, size_t uses);
+size_t upb_pbcodecache_jitbudget(const upb_pbcodecache *c);
+bool upb_pbcodecache_setjitbudget(upb_pbcodecache *c, size_t bytes);
+size_t upb_pbcodecache_jitbytes(const upb_pbcodecache *c);
 const upb_pbdecodermethod *upb_pbcodecache_getdecodermethod(
     upb_pbcodecache *c, const upb_pbdecodermethodopts *opts);
+const upb_pbdecodermethod *upb_pbcodecache_loaddecodermethod(
+    upb_pbcodecache *c, const upb_pbdecodermethodopts *opts,
+    const char *filename, upb_status *s);
+size_t upb_pbcodecache_hits(const upb_pbcodecache *c);
+size_t upb_pbcodecache_misses(const upb_pbcodecache *c);
+size_t upb_pbcodecache_compiledbytes(const upb_pbcodecache *c);
 
 UPB_END_EXTERN_C
 
@@ -263,7 +504,19 @@ inline size_t Decoder::max_nesting() const {
 inline bool Decoder::set_max_nesting(size_t max) {
   return upb_pbdecoder_setmaxnesting(this, max);
 }
+inline bool Decoder::delimited() const {
+  return upb_pbdecoder_delimited(this);
+}
+inline bool Decoder::set_delimited(bool delimited) {
+  return upb_pbdecoder_setdelimited(this, delimited);
+}
 inline void Decoder::Reset() { upb_pbdecoder_reset(this); }
+/* static */
+inline bool Decoder::DecodeParallel(const ParallelDecodeOptions& opts,
+                                    const char* buf, size_t len,
+                                    Status* status) {
+  return upb_pbdecoder_decodeparallel(&opts, buf, len, status);
+}
 
 inline DecoderMethodOptions::DecoderMethodOptions(const Handlers* h) {
   upb_pbdecodermethodopts_init(this, h);
@@ -271,6 +524,32 @@ inline DecoderMethodOptions::DecoderMethodOptions(const Handlers* h) {
 inline void DecoderMethodOptions::set_lazy(bool lazy) {
   upb_pbdecodermethodopts_setlazy(this, lazy);
 }
+inline void DecoderMethodOptions::set_field_mask(const FieldDef* const* fields,
+                                                 size_t n) {
+  upb_pbdecodermethodopts_setfieldmask(this, fields, n);
+}
+inline void DecoderMethodOptions::set_early_exit(bool early_exit) {
+  upb_pbdecodermethodopts_setearlyexit(this, early_exit);
+}
+inline void DecoderMethodOptions::set_verify_utf8(bool verify_utf8) {
+  upb_pbdecodermethodopts_setverifyutf8(this, verify_utf8);
+}
+
+inline ParallelDecodeOptions::ParallelDecodeOptions(const DecoderMethod* m,
+                                                    const FieldDef* f) {
+  upb_pbparallelopts_init(this, m, f);
+}
+inline void ParallelDecodeOptions::set_threads(size_t threads) {
+  upb_pbparallelopts_setthreads(this, threads);
+}
+inline void ParallelDecodeOptions::set_batch_size(size_t elements) {
+  upb_pbparallelopts_setbatchsize(this, elements);
+}
+inline void ParallelDecodeOptions::set_callbacks(SinkFunc* sink,
+                                                 MergeFunc* merge,
+                                                 void* closure) {
+  upb_pbparallelopts_setcallbacks(this, sink, merge, closure);
+}
 
 inline const Handlers* DecoderMethod::dest_handlers() const {
   return upb_pbdecodermethod_desthandlers(this);
@@ -281,12 +560,21 @@ inline const BytesHandler* DecoderMethod::input_handler() const {
 inline bool DecoderMethod::is_native() const {
   return upb_pbdecodermethod_isnative(this);
 }
+inline const DecoderMethod* DecoderMethod::FindSubMethod(
+    const FieldDef* f) const {
+  return upb_pbdecodermethod_submethod(this, f);
+}
 /* static */
 inline reffed_ptr<const DecoderMethod> DecoderMethod::New(
     const DecoderMethodOptions &opts) {
   const upb_pbdecodermethod *m = upb_pbdecodermethod_new(&opts, &m);
   return reffed_ptr<const DecoderMethod>(m, &m);
 }
+/* static */
+inline bool DecoderMethod::Save(const DecoderMethodOptions& opts,
+                                const char* filename, Status* status) {
+  return upb_pbdecodermethod_save(&opts, filename, status);
+}
 
 inline CodeCache::CodeCache() {
   upb_pbcodecache_init(this);
@@ -300,10 +588,38 @@ inline bool CodeCache::allow_jit() const {
 inline bool CodeCache::set_allow_jit(bool allow) {
   return upb_pbcodecache_setallowjit(this, allow);
 }
+inline size_t CodeCache::jit_threshold() const {
+  return upb_pbcodecache_jitthreshold(this);
+}
+inline bool CodeCache::set_jit_threshold(size_t uses) {
+  return upb_pbcodecache_setjitthreshold(this, uses);
+}
+inline size_t CodeCache::jit_budget() const {
+  return upb_pbcodecache_jitbudget(this);
+}
+inline bool CodeCache::set_jit_budget(size_t bytes) {
+  return upb_pbcodecache_setjitbudget(this, bytes);
+}
+inline size_t CodeCache::jit_bytes() const {
+  return upb_pbcodecache_jitbytes(this);
+}
 inline const DecoderMethod *CodeCache::GetDecoderMethod(
     const DecoderMethodOptions& opts) {
   return upb_pbcodecache_getdecodermethod(this, &opts);
 }
+inline const DecoderMethod *CodeCache::LoadDecoderMethod(
+    const DecoderMethodOptions& opts, const char* filename, Status* status) {
+  return upb_pbcodecache_loaddecodermethod(this, &opts, filename, status);
+}
+inline size_t CodeCache::hits() const {
+  return upb_pbcodecache_hits(this);
+}
+inline size_t CodeCache::misses() const {
+  return upb_pbcodecache_misses(this);
+}
+inline size_t CodeCache::compiled_bytes() const {
+  return upb_pbcodecache_compiledbytes(this);
+}
 
 }  /* namespace pb */
 }  /* namespace upb */
@@ -78,10 +78,66 @@ typedef enum {
 
   OP_DISPATCH       = 36,  /* No arg. */
 
-  OP_HALT           = 37   /* No arg. */
+  OP_HALT           = 37,  /* No arg. */
+
+  OP_CALLEXT        = 38,  /* N words: */
+                           /*   | unused (24)         | opc | */
+                           /*   | code ptr (32 or 64)       | */
+                           /* Like OP_CALL, but calls a method whose bytecode
+                            * lives in a different (linked) mgroup. */
+
+  /* Superinstructions, which the bytecode compiler substitutes for the first
+   * instruction of a common sequence (interpreted groups only).  Each one
+   * keeps the operands of the instruction it replaces and runs the rest of
+   * the sequence from the instructions that follow it, which stay in place so
+   * that jumps into the middle of the sequence still work. */
+
+  /* OP_CHECKDELIM, then the OP_TAG1 or OP_TAG2 and OP_PARSE_* that follow;
+   * ie. a whole non-repeated primitive field. */
+#define T(type) OP_FIELD1_PARSE_ ## type
+  T(DOUBLE) = 39, T(FLOAT), T(INT64), T(UINT64), T(INT32), T(FIXED64),
+  T(FIXED32), T(BOOL), T(UINT32), T(SFIXED32), T(SFIXED64), T(SINT32),
+  T(SINT64),
+#undef T
+#define T(type) OP_FIELD2_PARSE_ ## type
+  T(DOUBLE) = 52, T(FLOAT), T(INT64), T(UINT64), T(INT32), T(FIXED64),
+  T(FIXED32), T(BOOL), T(UINT32), T(SFIXED32), T(SFIXED64), T(SINT32),
+  T(SINT64),
+#undef T
+
+  /* OP_CHECKDELIM, then the OP_BRANCH that follows and the OP_PARSE_* it
+   * branches back to; ie. one iteration of a packed field's loop. */
+#define T(type) OP_LOOP_PARSE_ ## type
+  T(DOUBLE) = 65, T(FLOAT), T(INT64), T(UINT64), T(INT32), T(FIXED64),
+  T(FIXED32), T(BOOL), T(UINT32), T(SFIXED32), T(SFIXED64), T(SINT32),
+  T(SINT64),
+#undef T
+
+  OP_FIELD1          = 78, /* OP_CHECKDELIM, then OP_TAG1. */
+  OP_FIELD2          = 79, /* OP_CHECKDELIM, then OP_TAG2. */
+  OP_STARTSTR_STRING = 80, /* OP_STARTSTR, then OP_STRING if non-empty. */
+
+  /* Parses the rest of a packed field in batches, passing each batch to the
+   * field's array handler.  Only emitted for fields that have one. */
+  OP_PACKED          = 81, /* two words: */
+                           /*   | value selector (24)  | opc | */
+                           /*   | OP_PARSE_* for the values (32) | */
+
+  /* Marks a needed field as seen, and ends the message once all of them have
+   * been; see upb_pbdecodermethodopts_setearlyexit(). */
+  OP_SEEN            = 82, /* | needed count (16) | field bit (8) | opc | */
+
+  /* Reads the length of the next record of a delimited stream, pushes a frame
+   * for it and calls the decoder's method.  Only used by the interpreter's
+   * program for delimited streams; see upb_pbdecoder_setdelimited(). */
+  OP_RECORD          = 83, /* No arg. */
+
+  /* Like OP_STRING, but also checks that the string is valid UTF-8.  Emitted
+   * for proto3 string fields; see upb_pbdecodermethodopts_setverifyutf8(). */
+  OP_STRING_UTF8     = 84
 } opcode;
 
-#define OP_MAX OP_HALT
+#define OP_MAX OP_STRING_UTF8
 
 UPB_INLINE opcode getop(uint32_t instr) { return instr & 0xff; }
 
@@ -106,13 +162,21 @@ struct mgroup {
    * methods. */
   upb_inttable methods;
 
-  /* When we add the ability to link to previously existing mgroups, we'll
-   * need an array of mgroups we reference here, and own refs on them. */
+  /* Previously existing mgroups whose methods our bytecode calls with
+   * OP_CALLEXT.  Maps mgroup* -> unused; we own refs on the mgroups.  Linked
+   * groups are always older than we are, so they can never refer back to us. */
+  upb_inttable linked;
 
   /* The bytecode for our methods, if any exists.  Owned by us. */
   uint32_t *bytecode;
   uint32_t *bytecode_end;
 
+  /* If non-NULL, "bytecode" points into this mapped bytecode image (see
+   * upb_pbcodecache_loaddecodermethod()) instead of being separately
+   * allocated. */
+  void *image;
+  size_t image_size;
+
 #ifdef UPB_USE_JIT_X64
   /* JIT-generated machine code, if any. */
   upb_string_handlerfunc *jit_code;
@@ -123,16 +187,63 @@ struct mgroup {
 #endif
 };
 
-/* The maximum that any submessages can be nested.  Matches proto2's limit.
- * This specifies the size of the decoder's statically-sized array and therefore
- * setting it high will cause the upb::pb::Decoder object to be larger.
- *
- * If necessary we can add a runtime-settable property to Decoder that allow
- * this to be larger than the compile-time setting, but this would add
- * complexity, particularly since we would have to decide how/if to give users
- * the ability to set a custom memory allocation function. */
+/* The default limit on how deeply submessages can be nested.  Matches proto2's
+ * limit.  This is also the number of frames the decoder allocates when it is
+ * created, so that messages within the default limit never allocate while they
+ * are parsed.  upb_pbdecoder_setmaxnesting() can raise the limit, in which case
+ * the stacks grow on demand from the decoder's upb_env. */
 #define UPB_DECODER_MAX_NESTING 64
 
+/* The interpreter's form of a method's dispatch table, built from the
+ * "dispatch" inttable once the bytecode is final.  A single probe of
+ * "entries" finds the code for both of a field's wire types:
+ *
+ *   - field numbers below "array_size" index "entries" directly.
+ *   - other field numbers use a perfect hash built by the compiler; see
+ *     upb_pbdecoder_dispatchslot().  The slot only holds the field if its
+ *     "fieldnum" matches.
+ *
+ * Unused entries have both wire types set to NO_WIRE_TYPE, so they never
+ * match. */
+typedef struct {
+  uint32_t fieldnum;
+  uint32_t ofs;   /* Code for wire type wt1, relative to the method base. */
+  uint32_t ofs2;  /* Code for wire type wt2, relative to the method base. */
+  uint8_t wt1;
+  uint8_t wt2;
+} upb_pbdecoder_dispatchentry;
+
+typedef struct {
+  upb_pbdecoder_dispatchentry *entries;
+  uint32_t *seeds;        /* Hash seed for each bucket. */
+  uint32_t array_size;
+  uint32_t hash_size;     /* 0, or a power of two. */
+  uint32_t hash_buckets;  /* A power of two. */
+  uint32_t endmsg_ofs;    /* The DISPATCH_ENDMSG target. */
+} upb_pbdecoder_dispatchtable;
+
+/* A 32-bit integer hash (the MurmurHash3 finalizer) with a seed. */
+UPB_INLINE uint32_t upb_pbdecoder_dispatchhash(uint32_t key, uint32_t seed) {
+  uint32_t h = key ^ seed;
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+/* Returns the slot in the hash part of "t" that "fieldnum" would occupy.  The
+ * first hash picks a bucket, whose seed was chosen so that the second hash
+ * gives every field in the table a different slot. */
+UPB_INLINE uint32_t upb_pbdecoder_dispatchslot(
+    const upb_pbdecoder_dispatchtable *t, uint32_t fieldnum) {
+  uint32_t bucket =
+      upb_pbdecoder_dispatchhash(fieldnum, 0) & (t->hash_buckets - 1);
+  return upb_pbdecoder_dispatchhash(fieldnum, t->seeds[bucket]) &
+         (t->hash_size - 1);
+}
+
 /* Internal-only struct used by the decoder. */
 typedef struct {
   /* Space optimization note: we store two pointers here that the JIT
@@ -157,7 +268,10 @@ typedef struct {
    * A positive number indicates a known group.
    * A negative number indicates an unknown group. */
   int32_t groupnum;
-  upb_inttable *dispatch;  /* Not used by the JIT. */
+  const upb_pbdecoder_dispatchtable *dispatch;  /* Not used by the JIT. */
+
+  /* Bits for the needed fields seen so far, set by OP_SEEN. */
+  uint64_t seen;
 } upb_pbdecoder_frame;
 
 struct upb_pbdecodermethod {
@@ -182,6 +296,18 @@ struct upb_pbdecodermethod {
   /* Whether this method is native code or bytecode. */
   bool is_native_;
 
+  /* For tiered compilation (see upb_pbcodecache_setjitthreshold()).  An
+   * interpreted method that may be JIT compiled later counts how many messages
+   * it has decoded since the cache last looked at it.  "jit_refused_" is set
+   * (non-zero), with the cache's lock held, once its machine code turned out
+   * not to fit in the cache's JIT budget or not to be possible at all.  That
+   * is permanent, so lookups stop considering the method for promotion.
+   * "jit_refused_" and "uses_" are accessed atomically, since lookups read
+   * them without the lock. */
+  bool count_uses_;
+  size_t jit_refused_;
+  size_t uses_;
+
   /* The handler one calls to invoke this method. */
   upb_byteshandler input_handler_;
 
@@ -192,6 +318,10 @@ struct upb_pbdecodermethod {
    * field number that wasn't the one we were expecting to see.  See
    * decoder.int.h for the layout of this table. */
   upb_inttable dispatch;
+
+  /* Compact copy of "dispatch" for the bytecode decoder; empty if we were
+   * JIT-compiled. */
+  upb_pbdecoder_dispatchtable interp_dispatch;
 };
 
 struct upb_pbdecoder {
@@ -228,15 +358,41 @@ struct upb_pbdecoder {
    * user buffer. */
   size_t skip;
 
+  /* Whether the bytes in "skip" belong to an unknown field that is being
+   * delivered to an unknown field handler, so they have to be read after all. */
+  bool skip_unknown;
+
+  /* Set once OP_SEEN has ended the top-level message early.  The rest of the
+   * input is consumed without being parsed. */
+  bool stopped;
+
+  /* Whether the input is a sequence of length-delimited records, rather than
+   * a single message. */
+  bool delimited;
+
+  /* State of OP_STRING_UTF8 between buffers: how many continuation bytes the
+   * current character still needs, and the range the next one must be in. */
+  uint8_t utf8_need;
+  uint8_t utf8_lo;
+  uint8_t utf8_hi;
+
   /* Stores the user buffer passed to our decode function. */
   const char *buf_param;
   size_t size_param;
+  const upb_bufhandle *handle_param;
+
+  /* The handle we pass to string handlers: handle_param while we are parsing
+   * the user's buffer, NULL while we are parsing our residual buffer (which
+   * the user's handle can't pin). */
   const upb_bufhandle *handle;
 
-  /* Our internal stack. */
+  /* Our internal stack.  "stack_size" is the number of frames allocated for
+   * both stacks, which can be less than "max_nesting"; "limit" is the last
+   * frame we can use without growing them. */
   upb_pbdecoder_frame *stack, *top, *limit;
   const uint32_t **callstack;
   size_t stack_size;
+  size_t max_nesting;
 
   upb_status *status;
 
@@ -275,6 +431,9 @@ extern const char *kPbDecoderSubmessageTooLong;
 /* Access to decoderplan members needed by the decoder. */
 const char *upb_pbdecoder_getopname(unsigned int op);
 
+/* Counts a message decoded by "m", if it is counting its uses. */
+void upb_pbdecodermethod_countuse(const upb_pbdecodermethod *m);
+
 /* JIT codegen entry point. */
 void upb_pbdecoder_jit(mgroup *group);
 void upb_pbdecoder_freejit(mgroup *group);
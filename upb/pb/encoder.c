@@ -44,8 +44,26 @@
 **   (1) makes you always pay for exactly one copy, but its implementation is
 **       the simplest and its performance is predictable.
 **
-** So for now, we implement (1) only.  If we wish to optimize later, we should
-** be able to do it without affecting users.
+** So by default we implement (1).  (2) is available as an option (see
+** upb_pb_encoder_setspeculative()), which guesses each length's size from the
+** last length written for the same field.  Most submessages of a field tend to
+** need the same number of bytes for their length, so after the first message
+** we rarely have to memmove().
+**
+** Sinks that can write scattered data (eg. with writev()) can avoid the final
+** copy with upb_pb_encoder_setiovec().  The encoder then keeps the whole
+** message in its buffer, writing each length after its region instead of
+** before it, and hands the sink a list of pieces in output order: runs of the
+** buffer, the lengths, and large strings that it refers to in the caller's
+** (pinned) buffers rather than copying.
+**
+** Producers that can push the same message twice can avoid the buffering
+** altogether with two-pass encoding (see upb_pb_encoder_sizepass()).  The
+** first pass only measures: it records the length of every delimited region,
+** in the order the regions start, and outputs nothing.  The second pass then
+** knows each length as soon as its region starts, so it writes everything in
+** order into one buffer of exactly the right size, which it hands to the
+** output in a single call.
 **
 ** The strategy is to buffer the segments of data that do *not* depend on
 ** unknown lengths in one buffer, and keep a separate buffer of segment pointers
@@ -91,6 +109,27 @@ typedef struct {
   uint32_t seglen;  /* Length of the segment. */
 } upb_pb_encoder_segment;
 
+/* What the encoder does with the message that is pushed to it. */
+typedef enum {
+  ENCODE_BUFFERED,     /* Buffers submessages into segments (the default). */
+  ENCODE_SPECULATIVE,  /* Guesses the size of each length, option (2). */
+  ENCODE_IOVEC,        /* Outputs a list of pieces at the end. */
+  ENCODE_SIZE,         /* Only measures: the first pass of two. */
+  ENCODE_WRITE         /* Writes using the lengths measured by ENCODE_SIZE. */
+} encode_mode;
+
+/* The number of fields whose length sizes we remember for ENCODE_SPECULATIVE.
+ * Fields are mapped to these by the address of their handler data, so fields
+ * may share a guess, which only makes it worse. */
+#define SPECULATIVE_FIELDS 64
+
+/* For ENCODE_IOVEC, strings shorter than this are copied, because a piece of
+ * their own would cost the sink more than the copy. */
+#define IOVEC_MIN_REF 128
+
+/* The offset of a piece that is not in "buf". */
+#define IOV_EXTERNAL ((size_t)-1)
+
 struct upb_pb_encoder {
   upb_env *env;
 
@@ -115,11 +154,45 @@ struct upb_pb_encoder {
   upb_pb_encoder_segment *segbuf, *segptr, *seglimit;
 
   /* The stack of enclosing submessages.  Each entry in the stack points to the
-   * segment where this submessage's length is being accumulated. */
+   * segment where this submessage's length is being accumulated.  It grows as
+   * needed, and like our other buffers it is kept across messages. */
   int *stack, *top, *stacklimit;
 
   /* Depth of startmsg/endmsg calls. */
   int depth;
+
+  /* Two-pass encoding.  "sizes" has the length of every delimited region,
+   * in the order they start; the stack holds indexes into it.  While a region
+   * is open its entry holds the region's start (when measuring) or end (when
+   * writing) offset instead.  When measuring, "buf" only holds the current
+   * field and "size" counts the bytes before it; after measuring, "size" is
+   * the size of the whole message. */
+  encode_mode mode;
+  encode_mode default_mode;
+  bool sized;
+  size_t *sizes;
+  size_t sizes_len, sizes_size, sizes_next;
+  size_t size;
+
+  /* For ENCODE_SPECULATIVE, the size of the last length written for each
+   * field.  The segments are then a stack of the open delimited regions:
+   * "msglen" is the number of bytes we reserved for the region's length, and
+   * "seglen" is the offset of those bytes in "buf". */
+  uint8_t lensizes[SPECULATIVE_FIELDS];
+
+  /* For ENCODE_IOVEC, the pieces of output so far.  "buf" holds everything
+   * but the referenced strings; "iovofs" has the offset of each piece in it,
+   * or IOV_EXTERNAL.  The first "iov_done" bytes of "buf" are in pieces
+   * already, and "iov_extbytes" counts the bytes of the referenced strings,
+   * whose buffers we hold "pins" on.  An open region's segment has its start
+   * offset in the output (as "msglen") and the index of the piece reserved for
+   * its length (as "seglen"). */
+  upb_iovec *iov;
+  size_t *iovofs;
+  size_t iov_len, iov_size;
+  size_t iov_done, iov_extbytes;
+  upb_bufpin *pins;
+  size_t pins_len, pins_size;
 };
 
 /* low-level buffering ********************************************************/
@@ -176,9 +249,14 @@ static void encoder_advance(upb_pb_encoder *e, size_t bytes) {
 /* Call when all of the bytes for a handler have been written.  Flushes the
  * bytes if possible and necessary, returning false if this failed. */
 static bool commit(upb_pb_encoder *e) {
-  if (!e->top) {
+  if (e->mode == ENCODE_SIZE) {
+    /* We only need to count the bytes. */
+    e->size += e->ptr - e->buf;
+    e->ptr = e->buf;
+  } else if (!e->top && e->mode != ENCODE_WRITE && e->mode != ENCODE_IOVEC) {
     /* We aren't inside a delimited region.  Flush our accumulated bytes to
-     * the output.
+     * the output.  (ENCODE_WRITE and ENCODE_IOVEC output the whole message
+     * at the end.)
      *
      * TODO(haberman): in the future we may want to delay flushing for
      * efficiency reasons. */
@@ -200,6 +278,108 @@ static bool encode_bytes(upb_pb_encoder *e, const void *data, size_t len) {
   return true;
 }
 
+/* Writes string data, which we only count when measuring. */
+static bool encode_data(upb_pb_encoder *e, const char *data, size_t len) {
+  if (e->mode == ENCODE_SIZE) {
+    e->size += len;
+    return true;
+  }
+  return encode_bytes(e, data, len);
+}
+
+/* The offset of e->ptr from the start of the message.  When writing, "buf"
+ * holds the whole message. */
+static size_t offset(const upb_pb_encoder *e) {
+  size_t ret = e->ptr - e->buf;
+  return e->mode == ENCODE_SIZE ? e->size + ret : ret;
+}
+
+/* Call when "top" has just moved past the end of the stack.  Doubles the
+ * stack, returning false if it could not be allocated. */
+static bool grow_stack(upb_pb_encoder *e) {
+  size_t old_size = e->stacklimit - e->stack;
+  size_t new_size = old_size * 2;
+  int *new_stack = upb_env_realloc(e->env, e->stack, old_size * sizeof(int),
+                                   new_size * sizeof(int));
+
+  if (new_stack == NULL) {
+    return false;
+  }
+
+  e->top = new_stack + (e->top - e->stack);
+  e->stacklimit = new_stack + new_size;
+  e->stack = new_stack;
+  return true;
+}
+
+/* Pushes index "i" of "sizes" on the stack. */
+static bool push_size(upb_pb_encoder *e, size_t i) {
+  if (!e->top) {
+    e->top = e->stack;
+  } else if (++e->top == e->stacklimit && !grow_stack(e)) {
+    return false;
+  }
+  *e->top = i;
+  return true;
+}
+
+static void pop_size(upb_pb_encoder *e) {
+  e->top = e->top == e->stack ? NULL : e->top - 1;
+}
+
+/* Starts a delimited region when measuring: allocates its entry in "sizes"
+ * and remembers where it starts. */
+static bool start_sized(upb_pb_encoder *e) {
+  if (e->sizes_len == e->sizes_size) {
+    size_t new_size = UPB_MAX(e->sizes_size * 2, 16);
+    size_t *new_buf = upb_env_realloc(e->env, e->sizes,
+                                      e->sizes_size * sizeof(size_t),
+                                      new_size * sizeof(size_t));
+    if (new_buf == NULL) {
+      return false;
+    }
+    e->sizes = new_buf;
+    e->sizes_size = new_size;
+  }
+
+  e->sizes[e->sizes_len] = offset(e);
+  return push_size(e, e->sizes_len++);
+}
+
+/* Ends a delimited region when measuring.  Its length goes before it, so
+ * that counts towards the enclosing regions. */
+static bool end_sized(upb_pb_encoder *e) {
+  size_t *len = &e->sizes[*e->top];
+  *len = offset(e) - *len;
+  e->size += upb_varint_size(*len);
+  pop_size(e);
+  return true;
+}
+
+/* Starts a delimited region when writing: writes the length we measured for
+ * it, and remembers where it has to end. */
+static bool start_written(upb_pb_encoder *e) {
+  size_t i = e->sizes_next++;
+  size_t len;
+
+  if (i == e->sizes_len || !reserve(e, UPB_PB_VARINT_MAX_LEN)) {
+    return false;
+  }
+
+  len = e->sizes[i];
+  encoder_advance(e, upb_vencode64(len, e->ptr));
+  e->sizes[i] = offset(e) + len;
+  return push_size(e, i);
+}
+
+/* Ends a delimited region when writing.  If it didn't end where it did when
+ * we measured it, the two passes didn't push the same message. */
+static bool end_written(upb_pb_encoder *e) {
+  bool ok = offset(e) == e->sizes[*e->top];
+  pop_size(e);
+  return ok;
+}
+
 /* Finish the current run by adding the run totals to the segment and message
  * length. */
 static void accumulate(upb_pb_encoder *e) {
@@ -211,17 +391,10 @@ static void accumulate(upb_pb_encoder *e) {
   e->runbegin = e->ptr;
 }
 
-/* Call to indicate the start of delimited region for which the full length is
- * not yet known.  All data will be buffered until the length is known.
- * Delimited regions may be nested; their lengths will all be tracked properly. */
-static bool start_delim(upb_pb_encoder *e) {
+/* Pushes a new segment for a delimited region on the stack. */
+static bool push_segment(upb_pb_encoder *e) {
   if (e->top) {
-    /* We are already buffering, advance to the next segment and push it on the
-     * stack. */
-    accumulate(e);
-
-    if (++e->top == e->stacklimit) {
-      /* TODO(haberman): grow stack? */
+    if (++e->top == e->stacklimit && !grow_stack(e)) {
       return false;
     }
 
@@ -242,10 +415,8 @@ static bool start_delim(upb_pb_encoder *e) {
       e->segbuf = new_buf;
     }
   } else {
-    /* We were previously at the top level, start buffering. */
     e->segptr = e->segbuf;
     e->top = e->stack;
-    e->runbegin = e->ptr;
   }
 
   *e->top = e->segptr - e->segbuf;
@@ -255,11 +426,256 @@ static bool start_delim(upb_pb_encoder *e) {
   return true;
 }
 
+/* Pops the innermost segment off the stack. */
+static void pop_segment(upb_pb_encoder *e) {
+  if (e->top == e->stack) {
+    e->top = NULL;
+  } else {
+    e->top--;
+    e->segptr--;
+  }
+}
+
+/* The size of the last length we wrote for the field with handler data
+ * "key". */
+static uint8_t *lensize(upb_pb_encoder *e, const void *key) {
+  return &e->lensizes[((uintptr_t)key >> 4) % SPECULATIVE_FIELDS];
+}
+
+/* Starts a delimited region by reserving as many bytes for its length as the
+ * field's last length took. */
+static bool start_speculative(upb_pb_encoder *e, const void *key) {
+  uint8_t guess = *lensize(e, key);
+
+  if (!push_segment(e) || !reserve(e, guess)) {
+    return false;
+  }
+
+  e->segptr->msglen = guess;
+  e->segptr->seglen = e->ptr - e->buf;
+  encoder_advance(e, guess);
+  return true;
+}
+
+/* Ends a delimited region by writing its length, moving the region if we
+ * guessed the size of the length wrong. */
+static bool end_speculative(upb_pb_encoder *e, const void *key) {
+  size_t guess = e->segptr->msglen;
+  char *lenptr = e->buf + e->segptr->seglen;
+  size_t len = e->ptr - (lenptr + guess);
+  size_t lenbytes = upb_varint_size(len);
+
+  if (lenbytes != guess) {
+    if (lenbytes > guess) {
+      if (!reserve(e, lenbytes - guess)) {
+        return false;
+      }
+      lenptr = e->buf + e->segptr->seglen;
+    }
+    memmove(lenptr + lenbytes, lenptr + guess, len);
+    e->ptr = lenptr + lenbytes + len;
+  }
+
+  upb_vencode64(len, lenptr);
+  *lensize(e, key) = lenbytes;
+
+  /* Once the outermost region is finished, it can be flushed. */
+  pop_segment(e);
+  return commit(e);
+}
+
+/* The offset of e->ptr in the output, for ENCODE_IOVEC. */
+static size_t iov_offset(const upb_pb_encoder *e) {
+  return (e->ptr - e->buf) + e->iov_extbytes;
+}
+
+/* Appends a piece: "len" bytes at "base", or at offset "ofs" of "buf" if "ofs"
+ * isn't IOV_EXTERNAL. */
+static bool iov_add(upb_pb_encoder *e, const char *base, size_t ofs,
+                    size_t len) {
+  if (e->iov_len == e->iov_size) {
+    size_t new_size = UPB_MAX(e->iov_size * 2, 16);
+    upb_iovec *new_iov;
+    size_t *new_ofs;
+
+    new_iov = upb_env_realloc(e->env, e->iov, e->iov_size * sizeof(upb_iovec),
+                              new_size * sizeof(upb_iovec));
+    if (new_iov == NULL) {
+      return false;
+    }
+    e->iov = new_iov;
+
+    new_ofs = upb_env_realloc(e->env, e->iovofs, e->iov_size * sizeof(size_t),
+                              new_size * sizeof(size_t));
+    if (new_ofs == NULL) {
+      return false;
+    }
+    e->iovofs = new_ofs;
+    e->iov_size = new_size;
+  }
+
+  e->iov[e->iov_len].base = base;
+  e->iov[e->iov_len].len = len;
+  e->iovofs[e->iov_len++] = ofs;
+  return true;
+}
+
+/* Puts the bytes of "buf" that aren't in a piece yet into one, extending the
+ * last piece if they follow it in "buf". */
+static bool iov_flush(upb_pb_encoder *e) {
+  size_t end = e->ptr - e->buf;
+  size_t n = e->iov_len;
+
+  if (end == e->iov_done) {
+    return true;
+  } else if (n > 0 && e->iovofs[n - 1] != IOV_EXTERNAL &&
+             e->iovofs[n - 1] + e->iov[n - 1].len == e->iov_done) {
+    e->iov[n - 1].len += end - e->iov_done;
+  } else if (!iov_add(e, NULL, e->iov_done, end - e->iov_done)) {
+    return false;
+  }
+
+  e->iov_done = end;
+  return true;
+}
+
+/* Starts a delimited region by reserving a piece for its length. */
+static bool start_iovec(upb_pb_encoder *e) {
+  if (!push_segment(e) || !iov_flush(e) || !iov_add(e, NULL, IOV_EXTERNAL, 0)) {
+    return false;
+  }
+
+  e->segptr->msglen = iov_offset(e);
+  e->segptr->seglen = e->iov_len - 1;
+  return true;
+}
+
+/* Ends a delimited region by writing its length at the end of "buf" and
+ * pointing its piece there. */
+static bool end_iovec(upb_pb_encoder *e) {
+  size_t len = iov_offset(e) - e->segptr->msglen;
+  size_t i = e->segptr->seglen;
+
+  if (!iov_flush(e) || !reserve(e, UPB_PB_VARINT_MAX_LEN)) {
+    return false;
+  }
+
+  e->iovofs[i] = e->ptr - e->buf;
+  e->iov[i].len = upb_vencode64(len, e->ptr);
+  encoder_advance(e, e->iov[i].len);
+  e->iov_done = e->ptr - e->buf;
+
+  pop_segment(e);
+  return true;
+}
+
+/* Adds a piece that refers to the caller's string instead of copying it,
+ * pinning the caller's buffer until the message is output. */
+static bool iov_addref(upb_pb_encoder *e, const char *buf, size_t len,
+                       const upb_bufhandle *h) {
+  if (e->pins_len == e->pins_size) {
+    size_t new_size = UPB_MAX(e->pins_size * 2, 8);
+    upb_bufpin *new_pins =
+        upb_env_realloc(e->env, e->pins, e->pins_size * sizeof(upb_bufpin),
+                        new_size * sizeof(upb_bufpin));
+    if (new_pins == NULL) {
+      return false;
+    }
+    e->pins = new_pins;
+    e->pins_size = new_size;
+  }
+
+  upb_bufpin_init(&e->pins[e->pins_len]);
+  if (!upb_bufhandle_pin(h, &e->pins[e->pins_len])) {
+    return false;
+  }
+  e->pins_len++;
+
+  if (!iov_flush(e) || !iov_add(e, buf, IOV_EXTERNAL, len)) {
+    return false;
+  }
+  e->iov_extbytes += len;
+  return true;
+}
+
+/* Drops all pieces and the pins on the caller's buffers. */
+static void iov_clear(upb_pb_encoder *e) {
+  while (e->pins_len > 0) {
+    upb_bufpin_release(&e->pins[--e->pins_len]);
+  }
+  e->iov_len = 0;
+  e->iov_done = 0;
+  e->iov_extbytes = 0;
+  e->ptr = e->buf;
+}
+
+/* Hands the whole message to the output as one list of pieces. */
+static bool iov_output(upb_pb_encoder *e) {
+  bool ok = iov_flush(e);
+
+  if (ok) {
+    size_t i;
+    for (i = 0; i < e->iov_len; i++) {
+      if (e->iovofs[i] != IOV_EXTERNAL) {
+        e->iov[i].base = e->buf + e->iovofs[i];
+      }
+    }
+    ok = upb_bytessink_putiov(e->output_, e->subc, e->iov, e->iov_len);
+  }
+
+  iov_clear(e);
+  return ok;
+}
+
+/* Call to indicate the start of delimited region for which the full length is
+ * not yet known.  All data will be buffered until the length is known.
+ * Delimited regions may be nested; their lengths will all be tracked properly.
+ * "key" is the field's handler data. */
+static bool start_delim(upb_pb_encoder *e, const void *key) {
+  switch (e->mode) {
+    case ENCODE_SPECULATIVE:
+      return start_speculative(e, key);
+    case ENCODE_IOVEC:
+      return start_iovec(e);
+    case ENCODE_SIZE:
+      return start_sized(e);
+    case ENCODE_WRITE:
+      return start_written(e);
+    case ENCODE_BUFFERED:
+      break;
+  }
+
+  if (e->top) {
+    /* We are already buffering, finish the current run before we push the
+     * next segment on the stack. */
+    accumulate(e);
+  } else {
+    /* We were previously at the top level, start buffering. */
+    e->runbegin = e->ptr;
+  }
+
+  return push_segment(e);
+}
+
 /* Call to indicate the end of a delimited region.  We now know the length of
  * the delimited region.  If we are not nested inside any other delimited
  * regions, we can now emit all of the buffered data we accumulated. */
-static bool end_delim(upb_pb_encoder *e) {
+static bool end_delim(upb_pb_encoder *e, const void *key) {
   size_t msglen;
+
+  switch (e->mode) {
+    case ENCODE_SPECULATIVE:
+      return end_speculative(e, key);
+    case ENCODE_IOVEC:
+      return end_iovec(e);
+    case ENCODE_SIZE:
+      return end_sized(e);
+    case ENCODE_WRITE:
+      return end_written(e);
+    case ENCODE_BUFFERED:
+      break;
+  }
+
   accumulate(e);
   msglen = top(e)->msglen;
 
@@ -355,29 +771,48 @@ static bool startmsg(void *c, const void *hd) {
   upb_pb_encoder *e = c;
   UPB_UNUSED(hd);
   if (e->depth++ == 0) {
-    upb_bytessink_start(e->output_, 0, &e->subc);
+    if (e->mode == ENCODE_SIZE) {
+      e->sizes_len = 0;
+      e->size = 0;
+    } else {
+      size_t hint = e->mode == ENCODE_WRITE ? e->size : 0;
+      upb_bytessink_start(e->output_, hint, &e->subc);
+    }
   }
   return true;
 }
 
 static bool endmsg(void *c, const void *hd, upb_status *status) {
   upb_pb_encoder *e = c;
+  bool ok = true;
   UPB_UNUSED(hd);
   UPB_UNUSED(status);
   if (--e->depth == 0) {
-    upb_bytessink_end(e->output_);
+    if (e->mode == ENCODE_SIZE) {
+      commit(e);
+      e->sized = true;
+    } else {
+      if (e->mode == ENCODE_WRITE) {
+        ok = e->sizes_next == e->sizes_len && offset(e) == e->size;
+        if (ok) putbuf(e, e->buf, e->ptr - e->buf);
+        e->ptr = e->buf;
+      } else if (e->mode == ENCODE_IOVEC) {
+        ok = iov_output(e);
+      }
+      upb_bytessink_end(e->output_);
+    }
+    e->mode = e->default_mode;
   }
-  return true;
+  return ok;
 }
 
 static void *encode_startdelimfield(void *c, const void *hd) {
-  bool ok = encode_tag(c, hd) && commit(c) && start_delim(c);
+  bool ok = encode_tag(c, hd) && commit(c) && start_delim(c, hd);
   return ok ? c : UPB_BREAK;
 }
 
 static bool encode_enddelimfield(void *c, const void *hd) {
-  UPB_UNUSED(hd);
-  return end_delim(c);
+  return end_delim(c, hd);
 }
 
 static void *encode_startgroup(void *c, const void *hd) {
@@ -395,9 +830,21 @@ static void *encode_startstr(void *c, const void *hd, size_t size_hint) {
 
 static size_t encode_strbuf(void *c, const void *hd, const char *buf,
                             size_t len, const upb_bufhandle *h) {
+  upb_pb_encoder *e = c;
+  UPB_UNUSED(hd);
+  if (e->mode == ENCODE_IOVEC && len >= IOVEC_MIN_REF && h &&
+      upb_bufhandle_pinnable(h)) {
+    return iov_addref(e, buf, len, h) ? len : 0;
+  }
+  return encode_data(e, buf, len) ? len : 0;
+}
+
+/* Unknown fields arrive already encoded, so we copy them through. */
+static size_t encode_unknown(void *c, const void *hd, const char *buf,
+                             size_t len, const upb_bufhandle *h) {
   UPB_UNUSED(hd);
   UPB_UNUSED(h);
-  return encode_bytes(c, buf, len) ? len : 0;
+  return (encode_data(c, buf, len) && commit(c)) ? len : 0;
 }
 
 #define T(type, ctype, convert, encode)                                  \
@@ -437,6 +884,7 @@ static void newhandlers_callback(const void *closure, upb_handlers *h) {
 
   upb_handlers_setstartmsg(h, startmsg, NULL);
   upb_handlers_setendmsg(h, endmsg, NULL);
+  upb_handlers_setunknown(h, encode_unknown, NULL);
 
   m = upb_handlers_msgdef(h);
   for(upb_msg_field_begin(&i, m);
@@ -515,6 +963,12 @@ void upb_pb_encoder_reset(upb_pb_encoder *e) {
   e->segptr = NULL;
   e->top = NULL;
   e->depth = 0;
+  e->mode = e->default_mode;
+  e->sized = false;
+  e->sizes_len = 0;
+  e->sizes_next = 0;
+  e->size = 0;
+  iov_clear(e);
 }
 
 
@@ -525,11 +979,16 @@ const upb_handlers *upb_pb_encoder_newhandlers(const upb_msgdef *m,
   return upb_handlers_newfrozen(m, owner, newhandlers_callback, NULL);
 }
 
+/* Releases the pins of a message that never ended. */
+static void encoder_cleanup(void *ud) {
+  iov_clear(ud);
+}
+
 upb_pb_encoder *upb_pb_encoder_create(upb_env *env, const upb_handlers *h,
                                       upb_bytessink *output) {
   const size_t initial_bufsize = 256;
   const size_t initial_segbufsize = 16;
-  /* TODO(haberman): make this configurable. */
+  /* Only the initial size; the stack grows for deeper messages. */
   const size_t stack_size = 64;
 #ifndef NDEBUG
   const size_t size_before = upb_env_bytesallocated(env);
@@ -549,6 +1008,20 @@ upb_pb_encoder *upb_pb_encoder_create(upb_env *env, const upb_handlers *h,
   e->limit = e->buf + initial_bufsize;
   e->seglimit = e->segbuf + initial_segbufsize;
   e->stacklimit = e->stack + stack_size;
+  e->sizes = NULL;
+  e->sizes_size = 0;
+  e->default_mode = ENCODE_BUFFERED;
+  memset(e->lensizes, 1, sizeof(e->lensizes));
+  e->iov = NULL;
+  e->iovofs = NULL;
+  e->iov_size = 0;
+  e->pins = NULL;
+  e->pins_len = 0;
+  e->pins_size = 0;
+
+  if (!upb_env_addcleanup(env, encoder_cleanup, e)) {
+    return NULL;
+  }
 
   upb_pb_encoder_reset(e);
   upb_sink_reset(&e->input_, h, e);
@@ -564,3 +1037,55 @@ upb_pb_encoder *upb_pb_encoder_create(upb_env *env, const upb_handlers *h,
 }
 
 upb_sink *upb_pb_encoder_input(upb_pb_encoder *e) { return &e->input_; }
+
+void upb_pb_encoder_sizepass(upb_pb_encoder *e) {
+  assert(e->depth == 0);
+  e->mode = ENCODE_SIZE;
+  e->sized = false;
+}
+
+size_t upb_pb_encoder_encodedsize(const upb_pb_encoder *e) {
+  return e->sized ? e->size : 0;
+}
+
+bool upb_pb_encoder_writepass(upb_pb_encoder *e) {
+  assert(e->depth == 0);
+  if (!e->sized) return false;
+
+  /* The varint encoder reserves a whole varint's worth of bytes even for the
+   * last field, so we need that much slack. */
+  if (!reserve(e, e->size + UPB_PB_VARINT_MAX_LEN)) return false;
+
+  e->mode = ENCODE_WRITE;
+  e->sized = false;
+  e->sizes_next = 0;
+  return true;
+}
+
+bool upb_pb_encoder_speculative(const upb_pb_encoder *e) {
+  return e->default_mode == ENCODE_SPECULATIVE;
+}
+
+void upb_pb_encoder_setspeculative(upb_pb_encoder *e, bool speculative) {
+  assert(e->depth == 0);
+  if (speculative) {
+    e->default_mode = ENCODE_SPECULATIVE;
+  } else if (e->default_mode == ENCODE_SPECULATIVE) {
+    e->default_mode = ENCODE_BUFFERED;
+  }
+  e->mode = e->default_mode;
+}
+
+bool upb_pb_encoder_iovec(const upb_pb_encoder *e) {
+  return e->default_mode == ENCODE_IOVEC;
+}
+
+void upb_pb_encoder_setiovec(upb_pb_encoder *e, bool iovec) {
+  assert(e->depth == 0);
+  if (iovec) {
+    e->default_mode = ENCODE_IOVEC;
+  } else if (e->default_mode == ENCODE_IOVEC) {
+    e->default_mode = ENCODE_BUFFERED;
+  }
+  e->mode = e->default_mode;
+}
@@ -6,7 +6,8 @@
 **
 ** This encoder implementation does not have any access to any out-of-band or
 ** precomputed lengths for submessages, so it must buffer submessages internally
-** before it can emit the first byte.
+** before it can emit the first byte.  Producers that can push a message twice
+** can instead have the encoder measure it first (see StartSizePass()).
 */
 
 #ifndef UPB_ENCODER_H_
@@ -33,7 +34,7 @@ UPB_DECLARE_TYPE(upb::pb::Encoder, upb_pb_encoder)
  * constructed.  This hint may be an overestimate for some build configurations.
  * But if the decoder library is upgraded without recompiling the application,
  * it may be an underestimate. */
-#define UPB_PB_ENCODER_SIZE 768
+#define UPB_PB_ENCODER_SIZE 1024
 
 #ifdef __cplusplus
 
@@ -47,6 +48,48 @@ class upb::pb::Encoder {
   /* The input to the encoder. */
   Sink* input();
 
+  /* Resets the encoder so that it is ready for a new message, for example
+   * after one failed or was abandoned midway.  The encoder keeps the buffers
+   * and stack it has grown, so once it has seen messages of a given size and
+   * depth, encoding more of them allocates nothing.  Cancels a two-pass
+   * encoding in progress, but keeps speculative() and iovec() as they are. */
+  void Reset();
+
+  /* Two-pass encoding, for producers that can push the same message twice,
+   * such as one that walks a complete message in memory.  After
+   * StartSizePass(), the next message pushed to input() is only measured and
+   * nothing is output; encoded_size() then returns its encoded size.  After
+   * StartWritePass(), the message must be pushed again, exactly as before.
+   * Since every submessage length is known by then, it is written straight
+   * into a single buffer of encoded_size() bytes, which is put to the output
+   * all at once when the message ends.  This avoids buffering submessages
+   * and copying them into place.
+   *
+   * StartWritePass() returns false if there is no measured message or the
+   * buffer can't be allocated.  If the second message isn't the same as the
+   * first, it fails and nothing is written to the output. */
+  void StartSizePass();
+  size_t encoded_size() const;
+  bool StartWritePass();
+
+  /* Whether submessages are written in place, reserving room for each length
+   * by guessing its size from the last length of the same field.  If a guess
+   * is wrong the submessage is moved.  Otherwise (the default) submessages are
+   * buffered separately and copied into place once their lengths are known.
+   * The output is the same either way.  May only be changed between
+   * messages. */
+  bool speculative() const;
+  void set_speculative(bool speculative);
+
+  /* Whether each message is output in one BytesSink::PutIOVec() call, as a
+   * list of pieces that point into the encoder's buffer and, for long strings
+   * whose BufferHandle can be pinned, into the caller's buffers instead of
+   * copying them.  The caller's buffers stay pinned until the message ends.
+   * This and speculative() are exclusive: turning one on turns the other off.
+   * May only be changed between messages. */
+  bool iovec() const;
+  void set_iovec(bool iovec);
+
   /* Creates a new set of handlers for this MessageDef. */
   static reffed_ptr<const Handlers> NewHandlers(const MessageDef* msg);
 
@@ -63,8 +106,16 @@ UPB_BEGIN_EXTERN_C
 const upb_handlers *upb_pb_encoder_newhandlers(const upb_msgdef *m,
                                                const void *owner);
 upb_sink *upb_pb_encoder_input(upb_pb_encoder *p);
+void upb_pb_encoder_reset(upb_pb_encoder *e);
 upb_pb_encoder* upb_pb_encoder_create(upb_env* e, const upb_handlers* h,
                                       upb_bytessink* output);
+void upb_pb_encoder_sizepass(upb_pb_encoder *e);
+size_t upb_pb_encoder_encodedsize(const upb_pb_encoder *e);
+bool upb_pb_encoder_writepass(upb_pb_encoder *e);
+bool upb_pb_encoder_speculative(const upb_pb_encoder *e);
+void upb_pb_encoder_setspeculative(upb_pb_encoder *e, bool speculative);
+bool upb_pb_encoder_iovec(const upb_pb_encoder *e);
+void upb_pb_encoder_setiovec(upb_pb_encoder *e, bool iovec);
 
 UPB_END_EXTERN_C
 
@@ -79,6 +130,30 @@ inline Encoder* Encoder::Create(Environment* env, const Handlers* handlers,
 inline Sink* Encoder::input() {
   return upb_pb_encoder_input(this);
 }
+inline void Encoder::Reset() {
+  upb_pb_encoder_reset(this);
+}
+inline void Encoder::StartSizePass() {
+  upb_pb_encoder_sizepass(this);
+}
+inline size_t Encoder::encoded_size() const {
+  return upb_pb_encoder_encodedsize(this);
+}
+inline bool Encoder::StartWritePass() {
+  return upb_pb_encoder_writepass(this);
+}
+inline bool Encoder::speculative() const {
+  return upb_pb_encoder_speculative(this);
+}
+inline void Encoder::set_speculative(bool speculative) {
+  upb_pb_encoder_setspeculative(this, speculative);
+}
+inline bool Encoder::iovec() const {
+  return upb_pb_encoder_iovec(this);
+}
+inline void Encoder::set_iovec(bool iovec) {
+  upb_pb_encoder_setiovec(this, iovec);
+}
 inline reffed_ptr<const Handlers> Encoder::NewHandlers(
     const upb::MessageDef *md) {
   const Handlers* h = upb_pb_encoder_newhandlers(md, &h);
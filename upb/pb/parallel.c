@@ -0,0 +1,384 @@
+/*
+** upb::pb::Decoder::DecodeParallel()
+**
+** Decodes the elements of a repeated submessage field on several threads.
+** This works because a DecoderMethod is immutable and can be shared by any
+** number of decoders, and because each element of the field is a message of
+** its own once we know where it starts and ends.  Finding that out only takes
+** the lengths of the top-level message's fields, which is much cheaper than
+** decoding them.  So a single thread scans for the elements, and the elements
+** are then decoded in batches by a pool of threads, each batch with its own
+** decoder and sink.
+*/
+
+#include <stdlib.h>
+#include "upb/pb/decoder.int.h"
+#include "upb/pb/varint.int.h"
+
+#if !defined(UPB_THREAD_UNSAFE) && !defined(_WIN32)
+#define UPB_PARALLEL_THREADS
+#include <pthread.h>
+#endif
+
+typedef struct {
+  const char *ptr;
+  size_t len;
+} element;
+
+/* Shared by the calling thread and the workers. */
+typedef struct {
+  const upb_pbparallelopts *opts;
+
+  /* The elements found by the scan, and the batches they are split into. */
+  element *elements;
+  size_t elements_len;
+  size_t elements_size;
+  upb_sink *sinks;
+  size_t batches;
+
+  /* The fields below are protected by "lock" once there are workers. */
+#ifdef UPB_PARALLEL_THREADS
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+#endif
+  size_t next;  /* The next batch for a worker to decode. */
+  bool *done;   /* Whether each batch has been decoded. */
+  bool failed;
+  upb_status status;  /* The first error. */
+} state;
+
+
+/* Scanning *******************************************************************/
+
+static bool addelement(state *st, const char *ptr, size_t len) {
+  if (st->elements_len == st->elements_size) {
+    size_t new_size = UPB_MAX(st->elements_size * 2, 64);
+    element *elements = realloc(st->elements, new_size * sizeof(element));
+    if (!elements) return false;
+    st->elements = elements;
+    st->elements_size = new_size;
+  }
+  st->elements[st->elements_len].ptr = ptr;
+  st->elements[st->elements_len].len = len;
+  st->elements_len++;
+  return true;
+}
+
+/* Finds the elements of opts->field in the message in "buf", looking at the
+ * tags and lengths of its fields but not at their values. */
+static bool scan(state *st, const char *buf, size_t len) {
+  const char *p = buf;
+  const char *end = buf + len;
+  uint32_t fieldnum = upb_fielddef_number(st->opts->field);
+  size_t depth = 0;  /* Of the groups we are skipping over. */
+  upb_status *s = &st->status;
+
+  while (p < end) {
+    uint64_t tag;
+    uint64_t n;
+    if (upb_vdecode_run(p, end, &tag, 1, &p) != 1) {
+      upb_status_seterrmsg(s, "Unterminated varint.");
+      return false;
+    } else if (tag >> 3 == 0) {
+      upb_status_seterrmsg(s, "Saw invalid field number (0)");
+      return false;
+    }
+
+    switch (tag & 0x7) {
+      case UPB_WIRE_TYPE_VARINT:
+        if (upb_vdecode_run(p, end, &n, 1, &p) != 1) {
+          upb_status_seterrmsg(s, "Unterminated varint.");
+          return false;
+        }
+        break;
+      case UPB_WIRE_TYPE_64BIT:
+      case UPB_WIRE_TYPE_32BIT:
+        n = (tag & 0x7) == UPB_WIRE_TYPE_64BIT ? 8 : 4;
+        if (n > (size_t)(end - p)) {
+          upb_status_seterrmsg(s, "Unexpected EOF inside fixed-width field.");
+          return false;
+        }
+        p += n;
+        break;
+      case UPB_WIRE_TYPE_DELIMITED:
+        if (upb_vdecode_run(p, end, &n, 1, &p) != 1) {
+          upb_status_seterrmsg(s, "Unterminated varint.");
+          return false;
+        } else if (n > (size_t)(end - p)) {
+          upb_status_seterrmsg(s, "Unexpected EOF inside delimited field.");
+          return false;
+        }
+        if (depth == 0 && tag >> 3 == fieldnum && !addelement(st, p, n)) {
+          upb_status_seterrmsg(s, "Out of memory.");
+          return false;
+        }
+        p += n;
+        break;
+      case UPB_WIRE_TYPE_START_GROUP:
+        depth++;
+        break;
+      case UPB_WIRE_TYPE_END_GROUP:
+        if (depth == 0) {
+          upb_status_seterrmsg(s, "Unmatched END_GROUP tag.");
+          return false;
+        }
+        depth--;
+        break;
+      default:
+        upb_status_seterrmsg(s, "Invalid wire type");
+        return false;
+    }
+  }
+
+  if (depth > 0) {
+    upb_status_seterrmsg(s, "Unexpected EOF inside group.");
+    return false;
+  }
+  return true;
+}
+
+
+/* Decoding *******************************************************************/
+
+/* Decodes the elements of batch "batch" into its sink.  Can be called from any
+ * thread. */
+static bool decodebatch(const state *st, size_t batch, upb_status *status) {
+  size_t i = batch * st->opts->batch_size;
+  size_t end = UPB_MIN(i + st->opts->batch_size, st->elements_len);
+  upb_env env;
+  upb_pbdecoder *d;
+  bool ok;
+
+  upb_env_init(&env);
+  upb_env_reporterrorsto(&env, status);
+  d = upb_pbdecoder_create(&env, st->opts->method, &st->sinks[batch]);
+  ok = d != NULL;
+  for (; ok && i < end; i++) {
+    ok = upb_bufsrc_putbuf(st->elements[i].ptr, st->elements[i].len,
+                           upb_pbdecoder_input(d));
+  }
+  if (!ok && upb_ok(status)) {
+    /* A handler failed without reporting why. */
+    upb_status_seterrmsg(status, "Failed to decode batch.");
+  }
+  upb_env_uninit(&env);
+  return ok;
+}
+
+/* Records the first failure. */
+static void fail(state *st, const upb_status *status) {
+  if (!st->failed) {
+    st->failed = true;
+    upb_status_copy(&st->status, status);
+  }
+}
+
+static bool merge(const state *st, size_t batch, upb_status *status) {
+  if (!st->opts->merge_func(st->opts->closure, batch)) {
+    upb_status_seterrmsg(status, "Merge callback failed.");
+    return false;
+  }
+  return true;
+}
+
+static bool decodeserial(state *st) {
+  size_t i;
+  for (i = 0; i < st->batches; i++) {
+    upb_status status;
+    upb_status_clear(&status);
+    if (!decodebatch(st, i, &status) || !merge(st, i, &status)) {
+      fail(st, &status);
+      return false;
+    }
+  }
+  return true;
+}
+
+#ifdef UPB_PARALLEL_THREADS
+
+static void *worker(void *p) {
+  state *st = p;
+  for (;;) {
+    upb_status status;
+    size_t batch;
+    bool ok;
+
+    pthread_mutex_lock(&st->lock);
+    if (st->failed || st->next == st->batches) {
+      pthread_mutex_unlock(&st->lock);
+      return NULL;
+    }
+    batch = st->next++;
+    pthread_mutex_unlock(&st->lock);
+
+    upb_status_clear(&status);
+    ok = decodebatch(st, batch, &status);
+
+    pthread_mutex_lock(&st->lock);
+    st->done[batch] = true;
+    if (!ok) fail(st, &status);
+    pthread_cond_broadcast(&st->cond);
+    pthread_mutex_unlock(&st->lock);
+  }
+}
+
+static bool decodethreaded(state *st, size_t threads) {
+  pthread_t *workers = malloc(threads * sizeof(pthread_t));
+  size_t started = 0;
+  size_t i;
+  bool ok = true;
+
+  st->done = calloc(st->batches, sizeof(bool));
+  if (!workers || !st->done) {
+    free(workers);
+    return decodeserial(st);
+  }
+
+  pthread_mutex_init(&st->lock, NULL);
+  pthread_cond_init(&st->cond, NULL);
+  while (started < threads &&
+         pthread_create(&workers[started], NULL, worker, st) == 0) {
+    started++;
+  }
+
+  if (started == 0) {
+    ok = decodeserial(st);
+  } else {
+    /* Merge the batches in order as they are finished. */
+    for (i = 0; ok && i < st->batches; i++) {
+      upb_status status;
+      upb_status_clear(&status);
+
+      pthread_mutex_lock(&st->lock);
+      while (!st->done[i] && !st->failed) {
+        pthread_cond_wait(&st->cond, &st->lock);
+      }
+      ok = !st->failed;
+      pthread_mutex_unlock(&st->lock);
+
+      if (ok && !merge(st, i, &status)) {
+        /* Stops the workers too. */
+        pthread_mutex_lock(&st->lock);
+        fail(st, &status);
+        pthread_mutex_unlock(&st->lock);
+        ok = false;
+      }
+    }
+  }
+
+  for (i = 0; i < started; i++) {
+    pthread_join(workers[i], NULL);
+  }
+  pthread_cond_destroy(&st->cond);
+  pthread_mutex_destroy(&st->lock);
+  free(workers);
+  return ok;
+}
+
+#endif  /* UPB_PARALLEL_THREADS */
+
+bool upb_pbdecoder_decodeparallel(const upb_pbparallelopts *opts,
+                                  const char *buf, size_t len,
+                                  upb_status *status) {
+  const upb_fielddef *f = opts->field;
+  const upb_handlers *h = upb_pbdecodermethod_desthandlers(opts->method);
+  state st;
+  size_t i;
+  bool ok;
+
+  st.opts = opts;
+  st.elements = NULL;
+  st.elements_len = 0;
+  st.elements_size = 0;
+  st.sinks = NULL;
+  st.batches = 0;
+  st.next = 0;
+  st.done = NULL;
+  st.failed = false;
+  upb_status_clear(&st.status);
+
+  if (!upb_fielddef_isseq(f) ||
+      upb_fielddef_descriptortype(f) != UPB_DESCRIPTOR_TYPE_MESSAGE) {
+    upb_status_seterrmsg(&st.status,
+                         "Only repeated message fields can be decoded in "
+                         "parallel.");
+    ok = false;
+  } else if (upb_handlers_msgdef(h) != upb_fielddef_msgsubdef(f)) {
+    upb_status_seterrmsg(&st.status,
+                         "Method doesn't decode the field's message type.");
+    ok = false;
+  } else if (!opts->sink_func || !opts->merge_func) {
+    upb_status_seterrmsg(&st.status,
+                         "Sink and merge callbacks must be set with "
+                         "set_callbacks().");
+    ok = false;
+  } else {
+    ok = scan(&st, buf, len);
+  }
+
+  if (ok) {
+    st.batches = (st.elements_len + opts->batch_size - 1) / opts->batch_size;
+    st.sinks = malloc(UPB_MAX(st.batches, 1) * sizeof(upb_sink));
+    if (!st.sinks) {
+      upb_status_seterrmsg(&st.status, "Out of memory.");
+      ok = false;
+    }
+  }
+
+  for (i = 0; ok && i < st.batches; i++) {
+    if (!opts->sink_func(opts->closure, i, &st.sinks[i])) {
+      upb_status_seterrmsg(&st.status, "Sink callback failed.");
+      ok = false;
+    }
+  }
+
+  if (ok) {
+#ifdef UPB_PARALLEL_THREADS
+    size_t threads = UPB_MIN(opts->threads, st.batches);
+    ok = threads > 1 ? decodethreaded(&st, threads) : decodeserial(&st);
+#else
+    ok = decodeserial(&st);
+#endif
+  }
+
+  if (!ok && status) upb_status_copy(status, &st.status);
+  free(st.elements);
+  free(st.sinks);
+  free(st.done);
+  return ok;
+}
+
+
+/* upb_pbparallelopts *********************************************************/
+
+void upb_pbparallelopts_init(upb_pbparallelopts *opts,
+                             const upb_pbdecodermethod *m,
+                             const upb_fielddef *f) {
+  opts->method = m;
+  opts->field = f;
+  opts->threads = 1;
+  opts->batch_size = 1024;
+  opts->sink_func = NULL;
+  opts->merge_func = NULL;
+  opts->closure = NULL;
+}
+
+void upb_pbparallelopts_setthreads(upb_pbparallelopts *opts, size_t threads) {
+  assert(threads > 0);
+  opts->threads = threads;
+}
+
+void upb_pbparallelopts_setbatchsize(upb_pbparallelopts *opts,
+                                     size_t elements) {
+  assert(elements > 0);
+  opts->batch_size = elements;
+}
+
+void upb_pbparallelopts_setcallbacks(upb_pbparallelopts *opts,
+                                     upb_pbbatch_sinkfunc *sink,
+                                     upb_pbbatch_mergefunc *merge,
+                                     void *closure) {
+  opts->sink_func = sink;
+  opts->merge_func = merge;
+  opts->closure = closure;
+}
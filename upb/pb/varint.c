@@ -123,3 +123,49 @@ upb_decoderet upb_vdecode_max8_wright(upb_decoderet r) {
                             r.val | (b << 14));
   return my_r;
 }
+
+/* Eight one-byte varints are recognized with a single test and copied out
+ * together, since runs of small values are the common case for packed fields;
+ * anything longer goes through the check2 decoder. */
+size_t upb_vdecode_run(const char *p, const char *end, uint64_t *vals,
+                       size_t max, const char **end_p) {
+  size_t n = 0;
+  while (n < max && p < end) {
+    if (end - p >= 8 && max - n >= 8) {
+      uint64_t w;
+      memcpy(&w, p, sizeof(w));
+      if ((w & 0x8080808080808080ULL) == 0) {
+        int i;
+        for (i = 0; i < 8; i++) {
+          vals[n + i] = (uint8_t)p[i];
+        }
+        p += 8;
+        n += 8;
+        continue;
+      }
+    }
+    if (!(*p & 0x80)) {
+      vals[n++] = (uint8_t)*p++;
+    } else if (end - p >= UPB_PB_VARINT_MAX_LEN) {
+      upb_decoderet r = upb_vdecode_fast(p);
+      if (r.p == NULL) break;  /* Unterminated varint. */
+      vals[n++] = r.val;
+      p = r.p;
+    } else {
+      /* Fewer than ten bytes left: only take the varint if it ends before
+       * "end", which also keeps the shift below 64 bits. */
+      const char *q = p;
+      uint64_t val = 0;
+      int bitpos = 0;
+      while (q < end && (*q & 0x80)) {
+        val |= (uint64_t)(*q++ & 0x7fU) << bitpos;
+        bitpos += 7;
+      }
+      if (q == end) break;
+      vals[n++] = val | (uint64_t)(*q & 0x7fU) << bitpos;
+      p = q + 1;
+    }
+  }
+  *end_p = p;
+  return n;
+}
@@ -113,6 +113,42 @@ UPB_INLINE upb_decoderet upb_vdecode_max8_fast(upb_decoderet r) {
   return upb_vdecode_max8_massimino(r);
 }
 
+/* Returns a pointer just past the varint at "p" without decoding it, or NULL if
+ * it is unterminated.  Finds the varint's last byte by looking at the
+ * continuation bits of eight bytes at once, which is much cheaper than decoding
+ * when the value isn't needed, as when skipping unknown fields.  Like
+ * upb_vdecode_fast(), this may read up to ten bytes, so it must not be used
+ * unless there are at least ten bytes left in the buffer! */
+UPB_INLINE const char *upb_vskip_fast(const char *p) {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  /* A set bit for every byte that ends a varint; the lowest is the first. */
+  uint64_t w;
+  memcpy(&w, p, sizeof(w));
+  w = ~w & 0x8080808080808080ULL;
+  if (w) return p + __builtin_ctzll(w) / 8 + 1;
+  /* Bytes 8 and 9, loaded so that we stay within the ten bytes. */
+  memcpy(&w, p + 2, sizeof(w));
+  w = ~w & 0x8080808080808080ULL;
+  return w ? p + 2 + __builtin_ctzll(w) / 8 + 1 : NULL;
+#else
+  int i;
+  for (i = 0; i < UPB_PB_VARINT_MAX_LEN; i++) {
+    if (!(p[i] & 0x80)) return p + i + 1;
+  }
+  return NULL;
+#endif
+}
+
+/* Decodes a run of consecutive varints, like the payload of a packed repeated
+ * field, from [p, end) into "vals".  Stops once "max" values are decoded or
+ * the next varint is not wholly contained in the buffer (or is unterminated),
+ * and returns the number of values decoded.  "*end_p" is set to just past
+ * the last decoded varint.  Unlike the functions above this reads nothing
+ * past "end". */
+size_t upb_vdecode_run(const char *p, const char *end, uint64_t *vals,
+                       size_t max, const char **end_p);
+
 
 /* Encoding *******************************************************************/
 
@@ -109,6 +109,10 @@ class upb::Sink {
   bool StartMessage();
   bool EndMessage(Status* status);
 
+  /* Puts the next "len" bytes of the message's unknown fields, in wire format;
+   * see Handlers::SetUnknownHandler(). */
+  bool PutUnknown(const char *buf, size_t len, const BufferHandle *handle);
+
   /* Putting of individual values.  These work for both repeated and
    * non-repeated fields, but for repeated fields you must wrap them in
    * calls to StartSequence()/EndSequence(). */
@@ -120,6 +124,17 @@ class upb::Sink {
   bool PutDouble(Handlers::Selector s, double val);
   bool PutBool(Handlers::Selector s, bool val);
 
+  /* Putting of a run of values of a repeated field, which must also be
+   * wrapped in StartSequence()/EndSequence().  "s" is the selector of the
+   * field's value handler; see Handlers::SetInt32ArrayHandler(). */
+  bool PutInt32Array(Handlers::Selector s, const int32_t *vals, size_t n);
+  bool PutInt64Array(Handlers::Selector s, const int64_t *vals, size_t n);
+  bool PutUInt32Array(Handlers::Selector s, const uint32_t *vals, size_t n);
+  bool PutUInt64Array(Handlers::Selector s, const uint64_t *vals, size_t n);
+  bool PutFloatArray(Handlers::Selector s, const float *vals, size_t n);
+  bool PutDoubleArray(Handlers::Selector s, const double *vals, size_t n);
+  bool PutBoolArray(Handlers::Selector s, const bool *vals, size_t n);
+
   /* Putting of string/bytes values.  Each string can consist of zero or more
    * non-contiguous buffers of data.
    *
@@ -175,6 +190,10 @@ class upb::BytesSink {
   bool Start(size_t size_hint, void **subc);
   size_t PutBuffer(void *subc, const char *buf, size_t len,
                    const BufferHandle *handle);
+
+  /* Puts "n" buffers at once.  Sinks without an iovec handler get them one
+   * at a time from PutBuffer().  Returns true if they were all accepted. */
+  bool PutIOVec(void *subc, const upb_iovec *iov, size_t n);
   bool End();
 #else
 struct upb_bytessink {
@@ -251,6 +270,30 @@ UPB_INLINE size_t upb_bytessink_putbuf(upb_bytessink *s, void *subc,
                 buf, size, handle);
 }
 
+UPB_INLINE bool upb_bytessink_putiov(upb_bytessink *s, void *subc,
+                                     const upb_iovec *iov, size_t n) {
+  typedef upb_iovec_handlerfunc func;
+  func *putiov;
+  size_t i;
+  if (!s->handler) return true;
+  putiov = (func *)s->handler->table[UPB_IOVEC_SELECTOR].func;
+
+  if (putiov) {
+    return putiov(subc, upb_handlerattr_handlerdata(
+                            &s->handler->table[UPB_IOVEC_SELECTOR].attr),
+                  iov, n);
+  }
+
+  if (!s->handler->table[UPB_STRING_SELECTOR].func) return true;
+  for (i = 0; i < n; i++) {
+    if (upb_bytessink_putbuf(s, subc, iov[i].base, iov[i].len, NULL) <
+        iov[i].len) {
+      return false;
+    }
+  }
+  return true;
+}
+
 UPB_INLINE bool upb_bytessink_end(upb_bytessink *s) {
   typedef upb_endfield_handlerfunc func;
   func *end;
@@ -303,6 +346,37 @@ PUTVAL(double, double)
 PUTVAL(bool,   bool)
 #undef PUTVAL
 
+/* Puts a run of "n" values of a repeated field; "sel" is the selector of the
+ * field's value handler.  If the field has no array handler the values are
+ * delivered one at a time to its value handler. */
+#define PUTARRAY(type, ctype)                                                  \
+  UPB_INLINE bool upb_sink_put##type##array(upb_sink *s, upb_selector_t sel,   \
+                                            const ctype *vals, size_t n) {     \
+    typedef upb_##type##array_handlerfunc functype;                            \
+    functype *func;                                                            \
+    size_t i;                                                                  \
+    upb_selector_t arraysel = upb_handlers_getarrayselector(sel);              \
+    if (!s->handlers) return true;                                             \
+    func = (functype *)upb_handlers_gethandler(s->handlers, arraysel);         \
+    if (func) {                                                                \
+      const void *hd = upb_handlers_gethandlerdata(s->handlers, arraysel);     \
+      return func(s->closure, hd, vals, n);                                    \
+    }                                                                          \
+    for (i = 0; i < n; i++) {                                                  \
+      if (!upb_sink_put##type(s, sel, vals[i])) return false;                  \
+    }                                                                          \
+    return true;                                                               \
+  }
+
+PUTARRAY(int32,  int32_t)
+PUTARRAY(int64,  int64_t)
+PUTARRAY(uint32, uint32_t)
+PUTARRAY(uint64, uint64_t)
+PUTARRAY(float,  float)
+PUTARRAY(double, double)
+PUTARRAY(bool,   bool)
+#undef PUTARRAY
+
 UPB_INLINE void upb_sink_reset(upb_sink *s, const upb_handlers *h, void *c) {
   s->handlers = h;
   s->closure = c;
@@ -346,6 +420,19 @@ UPB_INLINE bool upb_sink_endmsg(upb_sink *s, upb_status *status) {
   return endmsg(s->closure, hd, status);
 }
 
+UPB_INLINE bool upb_sink_putunknown(upb_sink *s, const char *buf, size_t n,
+                                    const upb_bufhandle *handle) {
+  typedef upb_string_handlerfunc func;
+  func *unknown;
+  const void *hd;
+  if (!s->handlers) return true;
+  unknown = (func *)upb_handlers_gethandler(s->handlers, UPB_UNKNOWN_SELECTOR);
+
+  if (!unknown) return true;
+  hd = upb_handlers_gethandlerdata(s->handlers, UPB_UNKNOWN_SELECTOR);
+  return unknown(s->closure, hd, buf, n, handle) == n;
+}
+
 UPB_INLINE bool upb_sink_startseq(upb_sink *s, upb_selector_t sel,
                                   upb_sink *sub) {
   typedef upb_startfield_handlerfunc func;
@@ -452,6 +539,10 @@ inline bool Sink::StartMessage() {
 inline bool Sink::EndMessage(Status* status) {
   return upb_sink_endmsg(this, status);
 }
+inline bool Sink::PutUnknown(const char *buf, size_t len,
+                             const BufferHandle *handle) {
+  return upb_sink_putunknown(this, buf, len, handle);
+}
 inline bool Sink::PutInt32(Handlers::Selector sel, int32_t val) {
   return upb_sink_putint32(this, sel, val);
 }
@@ -473,6 +564,34 @@ inline bool Sink::PutDouble(Handlers::Selector sel, double val) {
 inline bool Sink::PutBool(Handlers::Selector sel, bool val) {
   return upb_sink_putbool(this, sel, val);
 }
+inline bool Sink::PutInt32Array(Handlers::Selector sel, const int32_t *vals,
+                                size_t n) {
+  return upb_sink_putint32array(this, sel, vals, n);
+}
+inline bool Sink::PutInt64Array(Handlers::Selector sel, const int64_t *vals,
+                                size_t n) {
+  return upb_sink_putint64array(this, sel, vals, n);
+}
+inline bool Sink::PutUInt32Array(Handlers::Selector sel, const uint32_t *vals,
+                                 size_t n) {
+  return upb_sink_putuint32array(this, sel, vals, n);
+}
+inline bool Sink::PutUInt64Array(Handlers::Selector sel, const uint64_t *vals,
+                                 size_t n) {
+  return upb_sink_putuint64array(this, sel, vals, n);
+}
+inline bool Sink::PutFloatArray(Handlers::Selector sel, const float *vals,
+                                size_t n) {
+  return upb_sink_putfloatarray(this, sel, vals, n);
+}
+inline bool Sink::PutDoubleArray(Handlers::Selector sel, const double *vals,
+                                 size_t n) {
+  return upb_sink_putdoublearray(this, sel, vals, n);
+}
+inline bool Sink::PutBoolArray(Handlers::Selector sel, const bool *vals,
+                               size_t n) {
+  return upb_sink_putboolarray(this, sel, vals, n);
+}
 inline bool Sink::StartString(Handlers::Selector sel, size_t size_hint,
                               Sink *sub) {
   return upb_sink_startstr(this, sel, size_hint, sub);
@@ -513,6 +632,9 @@ inline size_t BytesSink::PutBuffer(void *subc, const char *buf, size_t len,
                                    const BufferHandle *handle) {
   return upb_bytessink_putbuf(this, subc, buf, len, handle);
 }
+inline bool BytesSink::PutIOVec(void *subc, const upb_iovec *iov, size_t n) {
+  return upb_bytessink_putiov(this, subc, iov, n);
+}
 inline bool BytesSink::End() {
   return upb_bytessink_end(this);
 }
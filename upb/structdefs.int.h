@@ -119,6 +119,9 @@ struct upb_msgdef {
    * descriptor.upb.c. */
   bool primitives_have_presence;
 
+  /* The syntax of the file this message was defined in. */
+  upb_syntax_t syntax;
+
   /* TODO(haberman): proper extension ranges (there can be multiple). */
 };
 
@@ -129,7 +132,8 @@ struct upb_msgdef {
   {                                                                           \
     UPB_DEF_INIT(name, UPB_DEF_MSG, refs, ref2s), selector_count,             \
         submsg_field_count, itof, ntof,                                       \
-        UPB_EMPTY_STRTABLE_INIT(UPB_CTYPE_PTR), false, true                   \
+        UPB_EMPTY_STRTABLE_INIT(UPB_CTYPE_PTR), false, true,                  \
+        UPB_SYNTAX_PROTO2                                                     \
   }
 
 
@@ -268,7 +268,8 @@ static upb_tabkey strcopy(lookupkey_t k2) {
   char *str = malloc(k2.str.len + sizeof(uint32_t) + 1);
   if (str == NULL) return 0;
   memcpy(str, &k2.str.len, sizeof(uint32_t));
-  memcpy(str + sizeof(uint32_t), k2.str.str, k2.str.len + 1);
+  memcpy(str + sizeof(uint32_t), k2.str.str, k2.str.len);
+  str[sizeof(uint32_t) + k2.str.len] = '\0';
   return (uintptr_t)str;
 }
 
@@ -344,7 +345,7 @@ bool upb_strtable_lookup2(const upb_strtable *t, const char *key, size_t len,
 
 bool upb_strtable_remove2(upb_strtable *t, const char *key, size_t len,
                          upb_value *val) {
-  uint32_t hash = MurmurHash2(key, strlen(key), 0);
+  uint32_t hash = MurmurHash2(key, len, 0);
   upb_tabkey tabkey;
   if (rm(&t->t, strkey2(key, len), val, &tabkey, hash, &streql)) {
     free((void*)tabkey);